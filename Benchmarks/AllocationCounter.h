@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations made anywhere in the process so far, counted by
+// replacing the global operator new and delete
+uint64_t heapAllocationCount();
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Minimal benchmark runner: every benchmark is run for a fixed number of
+// warm-up and measured repetitions, each repetition performing a fixed number
+// of operations, and is summarised as nanoseconds per operation.
+struct BenchmarkStats {
+    double mean = 0.0;
+    double median = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double p95 = 0.0;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    int repetitions = 0;
+    long long operationsPerRepetition = 0;
+    std::vector<double> nsPerOperation;  // One sample per measured repetition
+    BenchmarkStats stats;
+    nlohmann::json counters;             // Benchmark-specific extra numbers
+};
+
+class BenchmarkRunner {
+public:
+    BenchmarkRunner(int repetitions, int warmupRepetitions, const std::string& filter)
+        : repetitions(repetitions), warmupRepetitions(warmupRepetitions), filter(filter) {}
+
+    // `setup` runs untimed before every repetition; `body` performs
+    // `operations` operations and is the only part that is timed.
+    BenchmarkResult* run(const std::string& name, long long operations,
+                         const std::function<void()>& setup,
+                         const std::function<void()>& body) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            return nullptr;
+        }
+
+        BenchmarkResult result;
+        result.name = name;
+        result.repetitions = repetitions;
+        result.operationsPerRepetition = operations;
+
+        for (int rep = 0; rep < warmupRepetitions + repetitions; rep++) {
+            if (setup) {
+                setup();
+            }
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto end = std::chrono::steady_clock::now();
+
+            if (rep >= warmupRepetitions) {
+                double ns = std::chrono::duration<double, std::nano>(end - start).count();
+                result.nsPerOperation.push_back(ns / static_cast<double>(operations));
+            }
+        }
+
+        result.stats = summarize(result.nsPerOperation);
+        std::cout << name << ": median " << result.stats.median << " ns/op, mean "
+                  << result.stats.mean << " ns/op, stddev " << result.stats.stddev
+                  << " (" << repetitions << " reps x " << operations << " ops)" << std::endl;
+
+        results.push_back(result);
+        return &results.back();
+    }
+
+    nlohmann::json toJson() const {
+        nlohmann::json j;
+        j["repetitions"] = repetitions;
+        j["warmupRepetitions"] = warmupRepetitions;
+        j["benchmarks"] = nlohmann::json::array();
+        for (const auto& result : results) {
+            nlohmann::json entry;
+            entry["name"] = result.name;
+            entry["repetitions"] = result.repetitions;
+            entry["operationsPerRepetition"] = result.operationsPerRepetition;
+            entry["nsPerOperation"] = {
+                {"mean", result.stats.mean},
+                {"median", result.stats.median},
+                {"stddev", result.stats.stddev},
+                {"min", result.stats.min},
+                {"max", result.stats.max},
+                {"p95", result.stats.p95},
+                {"samples", result.nsPerOperation}
+            };
+            entry["operationsPerSecond"] = result.stats.median > 0.0 ? 1.0e9 / result.stats.median : 0.0;
+            if (!result.counters.is_null()) {
+                entry["counters"] = result.counters;
+            }
+            j["benchmarks"].push_back(entry);
+        }
+        return j;
+    }
+
+private:
+    int repetitions;
+    int warmupRepetitions;
+    std::string filter;
+    std::deque<BenchmarkResult> results;  // Stable addresses for returned results
+
+    static BenchmarkStats summarize(std::vector<double> samples) {
+        BenchmarkStats stats;
+        if (samples.empty()) {
+            return stats;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double sample : samples) {
+            sum += sample;
+        }
+        stats.mean = sum / samples.size();
+
+        double variance = 0.0;
+        for (double sample : samples) {
+            variance += (sample - stats.mean) * (sample - stats.mean);
+        }
+        stats.stddev = samples.size() > 1 ? std::sqrt(variance / (samples.size() - 1)) : 0.0;
+
+        size_t mid = samples.size() / 2;
+        stats.median = samples.size() % 2 ? samples[mid] : 0.5 * (samples[mid - 1] + samples[mid]);
+        stats.min = samples.front();
+        stats.max = samples.back();
+        stats.p95 = samples[std::min(samples.size() - 1, static_cast<size_t>(std::ceil(0.95 * samples.size())) - 1)];
+        return stats;
+    }
+};
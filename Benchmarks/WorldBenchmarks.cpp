@@ -0,0 +1,432 @@
+// GL-free microbenchmarks for the world hot paths.
+//
+// Usage: world_benchmarks [--out results.json] [--repetitions N] [--warmup N] [--filter name]
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "AllocationCounter.h"
+#include "BenchmarkHarness.h"
+#include "World/ChunkManager.h"
+#include "World/Generation/BasicBiome.h"
+#include "Player/Player.h"
+#include "Renderer/OcclusionCuller.h"
+#include "Utils/ConfigReader.h"
+
+namespace {
+    const unsigned int WORLD_SEED = 1234;
+    const int RANDOM_ACCESS_COUNT = 1 << 16;
+    const int CAMERA_PATH_STEPS = 64;
+    const float CAMERA_PATH_STEP_SECONDS = 0.25f;  // Time per step, as seen by the prefetcher
+
+    // Deterministic camera path: heads along +X while weaving in Z, moving half
+    // a chunk per step so roughly every other step crosses a chunk border
+    glm::vec3 cameraPathPoint(int step, float voxelScale) {
+        float chunkWidth = Chunk::CHUNK_SIZE_X * voxelScale;
+        float x = step * 0.5f * chunkWidth;
+        float z = 6.0f * chunkWidth * std::sin(step * 0.1f);
+        return glm::vec3(x, 40.0f * voxelScale, z);
+    }
+
+    // Random world positions inside the area loaded around the origin
+    std::vector<glm::vec3> randomWorldPositions(int count, float voxelScale, int viewDistance) {
+        std::mt19937 gen(WORLD_SEED);
+        float extent = viewDistance * Chunk::CHUNK_SIZE_X * voxelScale;
+        std::uniform_real_distribution<float> horizontal(-extent, extent);
+        std::uniform_real_distribution<float> vertical(0.0f, 64.0f * voxelScale);  // Around the surface
+
+        std::vector<glm::vec3> positions(count);
+        for (auto& pos : positions) {
+            pos = glm::vec3(horizontal(gen), vertical(gen), horizontal(gen));
+        }
+        return positions;
+    }
+
+    std::unique_ptr<ChunkManager> createWorld(Config& config, Biome& biome, const glm::vec3& center) {
+        auto world = std::make_unique<ChunkManager>(config);
+        world->init(biome);
+        world->updateChunks(center);
+        world->finishPendingMeshes();
+        return world;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string outPath = "world_benchmarks.json";
+    std::string filter;
+    int repetitions = 10;
+    int warmup = 2;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--out results.json] [--repetitions N] [--warmup N] [--filter name]" << std::endl;
+            return 1;
+        }
+    }
+
+    Config config = loadConfig(CONFIG_FILE);
+    BasicBiome biome(config);
+    const float voxelScale = config.voxelScale;
+    const glm::vec3 origin(0.0f, 40.0f * voxelScale, 0.0f);
+
+    BenchmarkRunner runner(repetitions, warmup, filter);
+
+    // One world shared by the benchmarks that only read or locally modify it
+    std::unique_ptr<ChunkManager> world = createWorld(config, biome, origin);
+    // The chunk holding the surface at the origin
+    int surfaceHeight = 0;
+    world->getSurfaceHeight(0, 0, surfaceHeight);
+    int surfaceChunkX, surfaceChunkY, surfaceChunkZ;
+    world->worldToChunkCoords(glm::vec3(0.0f, surfaceHeight * voxelScale, 0.0f), surfaceChunkX, surfaceChunkY, surfaceChunkZ);
+    Chunk* meshChunk = world->getChunk(0, surfaceChunkY, 0);
+    const int viewDistance = 8;  // Stay well inside the loaded area
+    std::vector<glm::vec3> positions = randomWorldPositions(RANDOM_ACCESS_COUNT, voxelScale, viewDistance);
+
+    // Meshing reuses its buffers, so once warmed up it should not allocate.
+    // allocationsPerMesh counts every repetition, warm-up included.
+    const int meshIterations = 200;
+    uint64_t meshAllocations = 0;
+    auto countMeshAllocations = [&](BenchmarkResult* result) {
+        if (result) {
+            result->counters["allocationsPerMesh"] =
+                static_cast<double>(meshAllocations) / (static_cast<double>(repetitions + warmup) * meshIterations);
+        }
+        meshAllocations = 0;
+    };
+    
+    countMeshAllocations(runner.run("Chunk::generateMesh", meshIterations, nullptr, [&]() {
+        uint64_t allocationsBefore = heapAllocationCount();
+        for (int i = 0; i < meshIterations; i++) {
+            meshChunk->markDirty();
+            meshChunk->generateMesh();
+        }
+        meshAllocations += heapAllocationCount() - allocationsBefore;
+    }));
+
+    auto meshSnapshot = std::make_unique<Chunk::VoxelSnapshot>();
+    meshChunk->takeSnapshot(*meshSnapshot);
+    Chunk::Mesh lodMesh;
+    for (int level = 1; level < Chunk::LOD_LEVELS; level++) {
+        std::string name = "Chunk::generateLodMesh/" + std::to_string(Chunk::getLodCellSize(level)) + "x";
+        countMeshAllocations(runner.run(name, meshIterations, nullptr, [&]() {
+            uint64_t allocationsBefore = heapAllocationCount();
+            for (int i = 0; i < meshIterations; i++) {
+                Chunk::generateLodMesh(*meshSnapshot, level, lodMesh);
+            }
+            meshAllocations += heapAllocationCount() - allocationsBefore;
+        }));
+    }
+
+    // Views of a chunk and its neighbours: copied when nothing holds the
+    // current versions, shared while an earlier view is still alive
+    const int viewIterations = 1000;
+    runner.run("ChunkManager::getSnapshotView/copy", viewIterations, nullptr, [&]() {
+        for (int i = 0; i < viewIterations; i++) {
+            ChunkSnapshotView view = world->getSnapshotView(0, surfaceChunkY, 0);
+        }
+    });
+    ChunkSnapshotView heldView = world->getSnapshotView(0, surfaceChunkY, 0);
+    runner.run("ChunkManager::getSnapshotView/shared", viewIterations, nullptr, [&]() {
+        for (int i = 0; i < viewIterations; i++) {
+            ChunkSnapshotView view = world->getSnapshotView(0, surfaceChunkY, 0);
+        }
+    });
+    heldView = ChunkSnapshotView();
+
+    const int terrainIterations = 200;
+    runner.run("ChunkManager::generateTerrainForChunk", terrainIterations, nullptr, [&]() {
+        for (int i = 0; i < terrainIterations; i++) {
+            world->generateTerrainForChunk(0, surfaceChunkY, 0);
+        }
+    });
+
+    // The density field alone, for the surface chunk at the origin
+    DensityField::HeightMap densityHeights;
+    for (int z = 0; z < Chunk::CHUNK_SIZE_Z; z++) {
+        for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++) {
+            world->getSurfaceHeight(x, z, densityHeights[x + z * Chunk::CHUNK_SIZE_X]);
+        }
+    }
+    auto densityMask = std::make_unique<DensityField::SolidMask>();
+    runner.run("DensityField::sampleChunk", terrainIterations, nullptr, [&]() {
+        for (int i = 0; i < terrainIterations; i++) {
+            DensityField::sampleChunk(0, surfaceChunkY, 0, densityHeights, *densityMask);
+        }
+    });
+
+    volatile unsigned int sink = 0;
+    runner.run("ChunkManager::getVoxelBlockId/random", RANDOM_ACCESS_COUNT, nullptr, [&]() {
+        unsigned int sum = 0;
+        for (const auto& pos : positions) {
+            sum += world->getVoxelBlockId(pos);
+        }
+        sink = sink + sum;
+    });
+
+    std::mt19937 blockGen(WORLD_SEED);
+    std::vector<unsigned int> blockIds(RANDOM_ACCESS_COUNT);
+    for (auto& id : blockIds) {
+        id = blockGen() % 4;  // Air, grass, dirt, stone
+    }
+    runner.run("ChunkManager::setVoxel/random", RANDOM_ACCESS_COUNT,
+        // Apply the previous repetition's queued relighting outside the timed region
+        [&]() { world->processLightUpdates(); },
+        [&]() {
+            for (int i = 0; i < RANDOM_ACCESS_COUNT; i++) {
+                world->setVoxel(positions[i], blockIds[i]);
+            }
+        });
+
+    // Bulk edits, alternating between stone and air so every write changes
+    // a block. Relighting and remeshing happen outside the timed region.
+    const glm::ivec3 editCenter(0, 24, 0);
+    const int boxHalfSize = 16;
+    const int sphereRadius = 12;
+    unsigned int fillId = 0;
+    auto nextFill = [&]() {
+        world->processLightUpdates();
+        fillId = fillId == 3 ? 0 : 3;
+    };
+    // Prime both regions with air, so the first fill of every benchmark changes every voxel
+    world->fillBox(editCenter - boxHalfSize, editCenter + boxHalfSize - 1, 0);
+    
+    const int boxVoxels = (2 * boxHalfSize) * (2 * boxHalfSize) * (2 * boxHalfSize);
+    BenchmarkResult* boxResult = runner.run("ChunkManager::fillBox", boxVoxels, nextFill, [&]() {
+        world->fillBox(editCenter - boxHalfSize, editCenter + boxHalfSize - 1, fillId);
+    });
+    
+    world->fillBox(editCenter - boxHalfSize, editCenter + boxHalfSize - 1, 0);
+    fillId = 0;
+    const size_t sphereVoxels = world->fillSphere(editCenter, sphereRadius, 3);
+    world->fillSphere(editCenter, sphereRadius, 0);
+    BenchmarkResult* sphereResult = runner.run("ChunkManager::fillSphere", static_cast<long long>(sphereVoxels), nextFill, [&]() {
+        world->fillSphere(editCenter, sphereRadius, fillId);
+    });
+    
+    // The same random writes as setVoxel/random, as one edit list
+    std::vector<VoxelEdit> edits(RANDOM_ACCESS_COUNT);
+    for (int i = 0; i < RANDOM_ACCESS_COUNT; i++) {
+        edits[i].voxel = glm::ivec3(positions[i] / voxelScale);
+        edits[i].blockId = blockIds[i];
+    }
+    BenchmarkResult* editsResult = runner.run("ChunkManager::applyEdits/random", RANDOM_ACCESS_COUNT,
+        [&]() {
+            world->processLightUpdates();
+            for (auto& edit : edits) {
+                edit.blockId = (edit.blockId + 1) % 4;
+            }
+        },
+        [&]() { world->applyEdits(edits); });
+    
+    for (BenchmarkResult* result : {boxResult, sphereResult, editsResult}) {
+        if (result) {
+            result->counters["editsPerSecond"] = 1e9 / result->stats.median;
+        }
+    }
+    world->processLightUpdates();
+
+    Player player(world.get());
+    volatile bool collided = false;
+    runner.run("Player::checkCollision", RANDOM_ACCESS_COUNT, nullptr, [&]() {
+        bool any = false;
+        for (const auto& pos : positions) {
+            any |= player.checkCollision(pos);
+        }
+        collided = any;
+    });
+
+    // Visibility search from a few eye positions: above ground, at the
+    // surface and underground
+    const glm::vec3 eyePositions[] = {
+        origin, glm::vec3(0.0f, 20.0f * voxelScale, 0.0f), glm::vec3(0.0f, 4.0f * voxelScale, 0.0f)
+    };
+    volatile size_t visibleSink = 0;
+    runner.run("ChunkManager::findVisibleChunks", 3, nullptr, [&]() {
+        size_t visible = 0;
+        for (const auto& eye : eyePositions) {
+            visible += world->findVisibleChunks(eye).size();
+        }
+        visibleSink = visibleSink + visible;
+    });
+
+    // Occlusion culling from the surface eye, looking along +X: rasterizing
+    // the near chunks' occluders and testing the visible chunks
+    OcclusionCuller occlusionCuller(voxelScale);
+    for (const auto& coords : world->getChangedChunks()) {
+        Chunk* chunk = world->getChunk(coords.x, coords.y, coords.z);
+        if (chunk) {
+            occlusionCuller.setChunkOccluders(coords.x, coords.y, coords.z, chunk->getMesh().occluders);
+        }
+    }
+    const glm::vec3 occlusionEye = eyePositions[1];
+    glm::mat4 occlusionViewProjection =
+        glm::perspective(glm::radians(config.camera.fov), 16.0f / 9.0f, 0.1f, 100.0f) *
+        glm::lookAt(occlusionEye, occlusionEye + glm::vec3(1.0f, -0.1f, 0.3f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const std::vector<ChunkCoord> occlusionCandidates = world->findVisibleChunks(occlusionEye);
+    volatile size_t culledSink = 0;
+    runner.run("OcclusionCuller::frame", 1, nullptr, [&]() {
+        occlusionCuller.beginFrame(occlusionViewProjection);
+        culledSink = culledSink + occlusionCuller.cullChunks(occlusionCandidates).size();
+    });
+
+    // Streaming: a fresh world per repetition, warmed up at the path start,
+    // then timed while the camera follows the scripted path. Heap
+    // allocations made meanwhile (workers included) are counted too.
+    std::unique_ptr<ChunkManager> streamingWorld;
+    auto flyCameraPath = [&]() {
+        for (int step = 1; step <= CAMERA_PATH_STEPS; step++) {
+            glm::vec3 position = cameraPathPoint(step, voxelScale);
+            glm::vec3 heading = cameraPathPoint(step + 1, voxelScale) - position;
+            streamingWorld->updateChunks(position, heading / CAMERA_PATH_STEP_SECONDS, heading);
+        }
+    };
+    
+    uint64_t streamingAllocations = 0;
+    double streamingSeconds = 0.0;
+    int64_t bytesBeforeStreaming = 0;
+    int64_t streamingBytes = 0;  // Budgeted memory held by the streaming world at the end of the path
+    BenchmarkResult* streamingResult = runner.run("ChunkManager::updateChunks/cameraPath", CAMERA_PATH_STEPS,
+        [&]() {
+            streamingWorld.reset();
+            bytesBeforeStreaming = ResidencyGovernor::measureTrackedBytes();
+            streamingWorld = createWorld(config, biome, cameraPathPoint(0, voxelScale));
+        },
+        [&]() {
+            uint64_t allocationsBefore = heapAllocationCount();
+            auto start = std::chrono::steady_clock::now();
+            flyCameraPath();
+            streamingSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            streamingAllocations += heapAllocationCount() - allocationsBefore;
+            streamingBytes = ResidencyGovernor::measureTrackedBytes() - bytesBeforeStreaming;
+        });
+    if (streamingResult) {
+        // Warm-up repetitions included; they follow the same path
+        int totalRepetitions = repetitions + warmup;
+        streamingResult->counters["allocationsPerStep"] =
+            static_cast<double>(streamingAllocations) / (static_cast<double>(totalRepetitions) * CAMERA_PATH_STEPS);
+        streamingResult->counters["allocationsPerSecond"] = static_cast<double>(streamingAllocations) / streamingSeconds;
+        
+        // Of the chunks that came into view, the share prefetched in time
+        // (last repetition)
+        const ChunkStreamingStats& stats = streamingWorld->getStreamingStats();
+        uint64_t neededChunks = stats.prefetchHits + stats.prefetchMisses;
+        streamingResult->counters["prefetchHitRate"] =
+            neededChunks > 0 ? static_cast<double>(stats.prefetchHits) / neededChunks : 0.0;
+    }
+    streamingWorld.reset();
+    
+    // Streaming through a warm world: one world flies the path there and
+    // back until two round trips in a row allocate nothing (the pools have
+    // reached the peak the path needs), then each repetition flies it again.
+    // Loading and meshing reuse evicted chunks' memory by then, so
+    // allocationsPerMesh (every repetition, warm-up included) must be 0.
+    const int maxWarmRoundTrips = 16;
+    auto flyCameraPathAndBack = [&]() {
+        for (int i = 1; i <= 2 * CAMERA_PATH_STEPS; i++) {
+            int step = i <= CAMERA_PATH_STEPS ? i : 2 * CAMERA_PATH_STEPS - i;
+            int next = i < CAMERA_PATH_STEPS ? step + 1 : step - 1;
+            glm::vec3 position = cameraPathPoint(step, voxelScale);
+            glm::vec3 heading = cameraPathPoint(next, voxelScale) - position;
+            streamingWorld->updateChunks(position, heading / CAMERA_PATH_STEP_SECONDS, heading);
+        }
+        streamingWorld->finishPendingMeshes();
+    };
+    
+    uint64_t warmAllocations = 0;
+    uint64_t warmMeshes = 0;
+    BenchmarkResult* warmResult = runner.run("ChunkManager::updateChunks/warmStreaming", 2 * CAMERA_PATH_STEPS,
+        [&]() {
+            if (!streamingWorld) {
+                streamingWorld = createWorld(config, biome, cameraPathPoint(0, voxelScale));
+                int cleanTrips = 0;
+                for (int trip = 0; trip < maxWarmRoundTrips && cleanTrips < 2; trip++) {
+                    streamingWorld->resetStreamingStats();
+                    uint64_t allocationsBefore = heapAllocationCount();
+                    flyCameraPathAndBack();
+                    cleanTrips = heapAllocationCount() == allocationsBefore ? cleanTrips + 1 : 0;
+                }
+            }
+            streamingWorld->resetStreamingStats();
+        },
+        [&]() {
+            uint64_t allocationsBefore = heapAllocationCount();
+            flyCameraPathAndBack();
+            warmAllocations += heapAllocationCount() - allocationsBefore;
+            warmMeshes += streamingWorld->getStreamingStats().meshesBuilt;
+        });
+    bool warmStreamingAllocated = false;
+    if (warmResult) {
+        double allocationsPerMesh = warmMeshes > 0 ? static_cast<double>(warmAllocations) / warmMeshes : 0.0;
+        warmResult->counters["allocationsPerMesh"] = allocationsPerMesh;
+        warmResult->counters["meshesPerRepetition"] = static_cast<double>(warmMeshes) / (repetitions + warmup);
+        if (warmAllocations > 0) {
+            std::cerr << "Error: warm streaming made " << warmAllocations << " heap allocations over "
+                      << warmMeshes << " meshes (" << allocationsPerMesh << " per mesh)" << std::endl;
+            warmStreamingAllocated = true;
+        }
+    }
+    streamingWorld.reset();
+    
+    // The same path with a memory budget of half what it held above, on top
+    // of what the rest of the process holds. The governor shrinks the view
+    // early on and then keeps it.
+    const std::string budgetName = "ChunkManager::updateChunks/cameraPathBudget";
+    if (streamingBytes == 0 && budgetName.find(filter) != std::string::npos) {
+        // The unconstrained path was filtered out, so measure its start
+        bytesBeforeStreaming = ResidencyGovernor::measureTrackedBytes();
+        streamingWorld = createWorld(config, biome, cameraPathPoint(0, voxelScale));
+        streamingBytes = ResidencyGovernor::measureTrackedBytes() - bytesBeforeStreaming;
+        streamingWorld.reset();
+    }
+    Config budgetConfig = config;
+    budgetConfig.streaming.memoryBudgetMB =
+        static_cast<int>((ResidencyGovernor::measureTrackedBytes() + streamingBytes / 2) / (1024 * 1024));
+    BenchmarkResult* budgetResult = runner.run(budgetName, CAMERA_PATH_STEPS,
+        [&]() {
+            streamingWorld.reset();
+            streamingWorld = createWorld(budgetConfig, biome, cameraPathPoint(0, voxelScale));
+        },
+        flyCameraPath);
+    if (budgetResult) {
+        // Last repetition
+        const ResidencyGovernor& governor = streamingWorld->getResidencyGovernor();
+        budgetResult->counters["budgetMB"] = budgetConfig.streaming.memoryBudgetMB;
+        budgetResult->counters["trackedMB"] = governor.getTrackedBytes() / (1024.0 * 1024.0);
+        budgetResult->counters["viewDistance"] = governor.getViewDistance();
+        budgetResult->counters["shrinks"] = static_cast<double>(governor.getShrinkCount());
+        budgetResult->counters["grows"] = static_cast<double>(governor.getGrowCount());
+    }
+    streamingWorld.reset();
+
+    nlohmann::json report = runner.toJson();
+    report["context"] = {
+        {"compiler", __VERSION__},
+        {"buildType", BENCHMARK_BUILD_TYPE},
+        {"voxelScale", voxelScale},
+        {"chunkSize", {Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y, Chunk::CHUNK_SIZE_Z}},
+        {"seed", WORLD_SEED}
+    };
+
+    std::ofstream out(outPath);
+    if (!out.is_open()) {
+        std::cerr << "Failed to write benchmark results to " << outPath << std::endl;
+        return 1;
+    }
+    out << report.dump(2) << std::endl;
+    std::cout << "Benchmark results written to " << outPath << std::endl;
+    return warmStreamingAllocated ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+// Decoding of PackedFace instances (see Source/World/PackedFace.h), shared
+// by the voxel and shadow vertex shaders. VoxelRenderer inserts this file,
+// after the PACKED_* layout defines, in front of both.
+
+uniform vec3 chunkOrigin;  // World position of the drawn chunk's voxel (0, 0, 0)
+uniform float cellSize;    // Voxels per packed position: 1, 2 or 4 by LOD level
+uniform float voxelScale;
+
+// Outward normal and in-face axes of every BlockFace (TOP, BOTTOM, FRONT,
+// BACK, LEFT, RIGHT). v runs down the texture, so it points to -Y on sides.
+const vec3 FACE_NORMALS[6] = vec3[6](
+    vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0), vec3(0.0, 0.0, 1.0),
+    vec3(0.0, 0.0, -1.0), vec3(-1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0));
+const vec3 FACE_U_AXES[6] = vec3[6](
+    vec3(1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0),
+    vec3(1.0, 0.0, 0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, 1.0));
+const vec3 FACE_V_AXES[6] = vec3[6](
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, 1.0), vec3(0.0, -1.0, 0.0),
+    vec3(0.0, -1.0, 0.0), vec3(0.0, -1.0, 0.0), vec3(0.0, -1.0, 0.0));
+
+// Corners of the quad's two triangles, in face UV
+const vec2 QUAD_CORNERS[6] = vec2[6](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0));
+
+struct FaceVertex {
+    vec3 worldPos;
+    vec3 normal;
+    vec2 uv;  // 0-1 across the face
+    uint face;
+    uint blockId;
+    uint light;
+};
+
+FaceVertex unpackFaceVertex(uint packedFace, int vertexIndex) {
+    FaceVertex v;
+    vec3 local = vec3(float((packedFace >> PACKED_X_SHIFT) & PACKED_X_MASK),
+                      float((packedFace >> PACKED_Y_SHIFT) & PACKED_Y_MASK),
+                      float((packedFace >> PACKED_Z_SHIFT) & PACKED_Z_MASK));
+    v.face = (packedFace >> PACKED_FACE_SHIFT) & PACKED_FACE_MASK;
+    v.blockId = (packedFace >> PACKED_BLOCK_SHIFT) & PACKED_BLOCK_MASK;
+    v.light = (packedFace >> PACKED_LIGHT_SHIFT) & PACKED_LIGHT_MASK;
+    v.uv = QUAD_CORNERS[vertexIndex];
+    v.normal = FACE_NORMALS[v.face];
+
+    // Voxel positions are cube centres; the face lies half a cell out. A
+    // cell of n voxels starts half a voxel before its first voxel's centre.
+    vec3 offset = 0.5 * v.normal + (v.uv.x - 0.5) * FACE_U_AXES[v.face] + (v.uv.y - 0.5) * FACE_V_AXES[v.face];
+    v.worldPos = chunkOrigin + ((local + 0.5 + offset) * cellSize - 0.5) * voxelScale;
+    return v;
+}
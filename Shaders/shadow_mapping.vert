@@ -1,10 +1,11 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 instancePosition;
+layout (location = 0) in uint aPackedFace;  // One visible block face (PackedFace)
 
-uniform mat4 lightSpaceMatrix;
+// Cascade being rendered; its matrix is in the FrameUniforms block, which
+// VoxelRenderer declares in front of this file along with unpackFaceVertex()
+uniform int cascadeIndex;
 
 void main() {
-    vec3 worldPos = aPos + instancePosition;
-    gl_Position = lightSpaceMatrix * vec4(worldPos, 1.0);
-}
\ No newline at end of file
+    vec3 worldPos = unpackFaceVertex(aPackedFace, gl_VertexID).worldPos;
+    gl_Position = lightSpaceMatrices[cascadeIndex] * vec4(worldPos, 1.0);
+}
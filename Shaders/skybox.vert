@@ -3,12 +3,13 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+// view and projection come from the FrameUniforms block, declared in front
+// of this file by the application
 
 void main()
 {
     TexCoords = aPos;
-    vec4 pos = projection * view * vec4(aPos, 1.0);
+    // Remove the translation so the skybox stays centred on the camera
+    vec4 pos = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
     gl_Position = pos.xyww;  // This ensures the skybox is always rendered at maximum depth
 }
\ No newline at end of file
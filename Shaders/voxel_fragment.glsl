@@ -3,18 +3,42 @@ out vec4 FragColor;
 
 in vec2 TexCoord;
 flat in uint BlockId;
+flat in uint BlockLight;
 in vec3 FragPos;
 in vec3 Normal;
-in vec4 FragPosLightSpace;
 
 uniform sampler2D textureAtlas;
-uniform sampler2D shadowMap;
-uniform vec3 lightDir;
-uniform vec3 lightColor;
-uniform vec3 viewPos;
-uniform float ambientStrength;
+uniform sampler2DArray shadowMap;      // One layer per cascade
 
-float ShadowCalculation(vec4 fragPosLightSpace) {
+// Light, camera and cascade values come from the FrameUniforms block, which
+// VoxelRenderer declares in front of this file. Cascades are centred on the
+// camera and cascadeRadii holds one radius per component.
+
+// Warm tint of light emitted by blocks such as lava
+const vec3 blockLightColor = vec3(1.0, 0.6, 0.3);
+
+// VoxelRenderer builds one program per render layer: ALPHA_TEST is defined
+// for the cutout layer and TRANSLUCENT for the blended layer
+#ifdef TRANSLUCENT
+const float translucentAlpha = 0.7;
+#endif
+
+float ShadowCalculation(vec3 fragPos) {
+    // Use the smallest cascade that covers the fragment, keeping a margin
+    // for texel snapping and the PCF kernel
+    float distanceToCamera = length(fragPos - viewPos);
+    int cascade = -1;
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+        if (distanceToCamera < cascadeRadii[i] * 0.95) {
+            cascade = i;
+            break;
+        }
+    }
+    if (cascade < 0) {
+        return 0.0; // No shadow beyond the last cascade
+    }
+    vec4 fragPosLightSpace = lightSpaceMatrices[cascade] * vec4(fragPos, 1.0);
+    
     // Perform perspective divide
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     
@@ -29,7 +53,7 @@ float ShadowCalculation(vec4 fragPosLightSpace) {
     }
     
     // Get closest depth value from light's perspective
-    float closestDepth = texture(shadowMap, projCoords.xy).r;
+    float closestDepth = texture(shadowMap, vec3(projCoords.xy, cascade)).r;
     
     // Get current depth
     float currentDepth = projCoords.z;
@@ -39,12 +63,12 @@ float ShadowCalculation(vec4 fragPosLightSpace) {
     
     // PCF (Percentage Closer Filtering) with larger kernel for softer shadows
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
     int pcfRadius = 2; // Larger radius for softer shadows
     
     for(int x = -pcfRadius; x <= pcfRadius; ++x) {
         for(int y = -pcfRadius; y <= pcfRadius; ++y) {
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
+            float pcfDepth = texture(shadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, cascade)).r;
             shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
         }
     }
@@ -61,6 +85,11 @@ float ShadowCalculation(vec4 fragPosLightSpace) {
 void main() {
     // Sample texture based on UV coordinates
     vec4 texColor = texture(textureAtlas, TexCoord);
+#ifdef ALPHA_TEST
+    if (texColor.a < 0.5) {
+        discard;
+    }
+#endif
     
     // Ambient lighting
     vec3 ambient = ambientStrength * lightColor;
@@ -78,10 +107,17 @@ void main() {
     vec3 specular = specularStrength * spec * lightColor;
     
     // Calculate shadow
-    float shadow = ShadowCalculation(FragPosLightSpace);
+    float shadow = ShadowCalculation(FragPos);
+    
+    // Block light is unaffected by the sun's shadow map
+    vec3 emitted = (float(BlockLight) / 15.0) * blockLightColor;
     
     // Apply lighting with shadows
-    vec3 result = (ambient + (1.0 - shadow) * (diffuse + specular)) * texColor.rgb;
+    vec3 result = (ambient + emitted + (1.0 - shadow) * (diffuse + specular)) * texColor.rgb;
     
+#ifdef TRANSLUCENT
+    FragColor = vec4(result, texColor.a * translucentAlpha);
+#else
     FragColor = vec4(result, texColor.a);
+#endif
 }
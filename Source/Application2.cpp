@@ -10,15 +10,21 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <nlohmann/json.hpp>
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
-#define STB_PERLIN_IMPLEMENTATION
-#include "stb_perlin.h"
-#include "Utils/SystemUsage.cpp"
-#include "World/Voxel.h" // Include the Voxel header
+#include "Utils/SystemUsage.h"
+#include "Renderer/VoxelRenderer.h"
+#include "Renderer/OffscreenContext.h"
+#include "Renderer/OcclusionCuller.h"
 #include "Utils/ConfigReader.h"// Include the ConfigReader header
 #include "Utils/HeightMapGenerator.h"
 #include "Utils/ShaderUtils.h"
@@ -27,6 +33,9 @@
 #include "World/Generation/BasicBiome.h"
 #include "World/ChunkManager.h" // Include the ChunkManager header
 #include "Player/Player.h" // Include the Player header
+#include "Utils/Profiler.h"
+#include "Utils/ProfilerView.h"
+#include "Utils/MemoryTracker.h"
 
 Config config = loadConfig(CONFIG_FILE);
 
@@ -65,6 +74,17 @@ bool moveLeft = false;
 bool moveRight = false;
 bool jumping = false;
 
+// Profiler trace export (P key)
+const std::string PROFILE_TRACE_FILE = "profile_trace.json";
+bool exportingTrace = false;
+
+// Memory report dump (M key)
+const std::string MEMORY_REPORT_FILE = "memory_report.json";
+bool dumpingMemory = false;
+
+// Headless flythrough benchmark (--benchmark <report.json> [--frames N])
+const int BENCHMARK_DEFAULT_FRAMES = 600;
+
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
     glViewport(0, 0, width, height);
@@ -88,6 +108,34 @@ void processInput(GLFWwindow *window)
         jumping = false;
     }
     
+#ifdef VOXEL_ENABLE_PROFILER
+    // Export the buffered profiler zones when P is pressed
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && !exportingTrace) {
+        if (Profiler::exportChromeTrace(PROFILE_TRACE_FILE))
+            std::cout << "Profiler trace written to " << PROFILE_TRACE_FILE << std::endl;
+        else
+            std::cerr << "Failed to write profiler trace to " << PROFILE_TRACE_FILE << std::endl;
+        exportingTrace = true;
+    }
+    
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE) {
+        exportingTrace = false;
+    }
+#endif
+
+    // Dump per-subsystem memory accounting when M is pressed
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !dumpingMemory) {
+        if (MemoryTracker::dumpJson(MEMORY_REPORT_FILE))
+            std::cout << "Memory report written to " << MEMORY_REPORT_FILE << std::endl;
+        else
+            std::cerr << "Failed to write memory report to " << MEMORY_REPORT_FILE << std::endl;
+        dumpingMemory = true;
+    }
+    
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE) {
+        dumpingMemory = false;
+    }
+
     // Spawn player at random location when R is pressed
     if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
         player->spawnRandomly();
@@ -126,7 +174,7 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos)
 
 // Add skybox variables
 unsigned int skyboxVAO, skyboxVBO;
-unsigned int skyboxShader;
+ShaderUtils::ShaderProgram skyboxProgram;
 CubemapTexture* skyboxTexture;
 
 float skyboxVertices[] = {
@@ -188,12 +236,374 @@ std::string loadShaderSource(const std::string& filePath) {
     return shaderStream.str();
 }
 
-unsigned int createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath) {
-    return ShaderUtils::createShaderProgram(vertexPath, fragmentPath);
+unsigned int loadTextureAtlas() {
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // Set texture wrapping/filtering options
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    int tx_width, tx_height, nrChannels;
+
+    unsigned char *data = stbi_load((std::string(ASSETS_DIR) + "/atlas.png").c_str(), &tx_width, &tx_height, &nrChannels, 0);
+    if (data)
+    {
+        if (nrChannels == 3)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tx_width, tx_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+        else if (nrChannels == 4)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tx_width, tx_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        else
+            std::cerr << "Error: Unsupported number of channels in texture\n";
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    else
+    {
+        std::cerr << "Failed to load texture\n";
+    }
+    stbi_image_free(data);
+    return texture;
+}
+
+void initVoxelRenderer(VoxelRenderer& voxelRenderer, unsigned int texture) {
+    voxelRenderer.init();
+    voxelRenderer.setTextureAtlas(texture);
+
+    // Set lighting properties
+    voxelRenderer.setLightDir(glm::vec3(-0.2f, -1.0f, -0.3f));
+    voxelRenderer.setLightColor(glm::vec3(1.0f, 1.0f, 1.0f));
+    voxelRenderer.setAmbientStrength(0.4f);
+}
+
+bool initSkybox() {
+    glGenVertexArrays(1, &skyboxVAO);
+    glGenBuffers(1, &skyboxVBO);
+    glBindVertexArray(skyboxVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+
+    // Create and compile skybox shader; it reads the camera from the
+    // renderer's frame uniform block
+    skyboxProgram.load("Shaders/skybox.vert", "Shaders/skybox.frag",
+                       VoxelRenderer::getFrameUniformsDeclaration());
+    skyboxProgram.bindUniformBlock("FrameUniforms", VoxelRenderer::FRAME_UNIFORMS_BINDING);
+    std::string skyboxDir = std::string(ASSETS_DIR) + "/Clouds/" + config.skyname;
+
+    skyboxTexture = new CubemapTexture(
+        skyboxDir + "/px.png", // +X
+        skyboxDir + "/nx.png", // -X
+        skyboxDir + "/py.png", // +Y
+        skyboxDir + "/ny.png", // -Y
+        skyboxDir + "/pz.png", // +Z
+        skyboxDir + "/nz.png"  // -Z
+    );
+    if (!skyboxTexture->Load()) {
+        std::cerr << "Failed to load skybox textures!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Needs VoxelRenderer::beginFrame() to have run this frame
+void drawSkybox() {
+    PROFILE_SCOPE("Skybox");
+    glDepthFunc(GL_LEQUAL);
+    skyboxProgram.use();
+
+    glBindVertexArray(skyboxVAO);
+    skyboxTexture->Bind(GL_TEXTURE0);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+}
+
+// Hand the chunks remeshed or unloaded by the last updateChunks call to the
+// renderer and the occlusion culler: re-upload or drop their meshes and
+// occluders and invalidate the shadow cascades covering them
+void syncChangedChunks(VoxelRenderer& voxelRenderer, OcclusionCuller& occlusionCuller) {
+    for (const auto& coords : chunkManager->getChangedChunks()) {
+        Chunk* chunk = chunkManager->getChunk(coords.x, coords.y, coords.z);
+        if (chunk) {
+            voxelRenderer.uploadChunkMesh(coords.x, coords.y, coords.z, chunk->getMesh(), chunk->getActiveLod());
+            occlusionCuller.setChunkOccluders(coords.x, coords.y, coords.z, chunk->getMesh().occluders);
+        } else {
+            voxelRenderer.removeChunkMesh(coords.x, coords.y, coords.z);
+            occlusionCuller.removeChunk(coords.x, coords.y, coords.z);
+        }
+        
+        glm::vec3 minCorner, maxCorner;
+        chunkManager->getChunkWorldBounds(coords.x, coords.y, coords.z, minCorner, maxCorner);
+        voxelRenderer.invalidateShadowRegion(minCorner, maxCorner);
+    }
+}
+
+// Camera path for the flythrough benchmark: a Catmull-Rom spline through
+// fixed control points (in chunk widths), flown above the tallest terrain
+glm::vec3 benchmarkCameraPath(float t) {
+    static const glm::vec2 controlPoints[] = {
+        {0.0f, 0.0f}, {0.0f, 0.0f}, {6.0f, 2.0f}, {12.0f, -3.0f},
+        {18.0f, 4.0f}, {24.0f, 0.0f}, {30.0f, -6.0f}, {36.0f, -2.0f}, {36.0f, -2.0f}
+    };
+    const int segmentCount = static_cast<int>(sizeof(controlPoints) / sizeof(controlPoints[0])) - 3;
+
+    float segmentPos = std::min(std::max(t, 0.0f), 1.0f) * segmentCount;
+    int segment = std::min(static_cast<int>(segmentPos), segmentCount - 1);
+    float u = segmentPos - segment;
+
+    const glm::vec2& p0 = controlPoints[segment];
+    const glm::vec2& p1 = controlPoints[segment + 1];
+    const glm::vec2& p2 = controlPoints[segment + 2];
+    const glm::vec2& p3 = controlPoints[segment + 3];
+    glm::vec2 point = 0.5f * (2.0f * p1 + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u * u +
+                              (3.0f * p1 - p0 - 3.0f * p2 + p3) * u * u * u);
+
+    float chunkWidth = Chunk::CHUNK_SIZE_X * VOXEL_SCALE;
+    // The heightmap stays below vox_maxHeight, overhangs lift the ground at
+    // most OVERHANG_HEIGHT above it and trees stand on top of that. The path
+    // flies a few voxels clear of all of them.
+    const int clearance = 4;
+    int heightVoxels =
+        config.gridConfig.vox_maxHeight + DensityField::OVERHANG_HEIGHT + ChunkManager::TREE_HEIGHT + clearance;
+    float height = heightVoxels * VOXEL_SCALE;
+    return glm::vec3(point.x * chunkWidth, height, point.y * chunkWidth);
+}
+
+// Mean and nearest-rank percentiles of a set of samples
+nlohmann::json summarizeSamples(std::vector<double> samples) {
+    if (samples.empty()) {
+        return {{"count", 0}};
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+        return samples[std::min(std::max<size_t>(rank, 1), samples.size()) - 1];
+    };
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    return {
+        {"count", samples.size()},
+        {"mean", sum / samples.size()},
+        {"p50", percentile(0.50)},
+        {"p95", percentile(0.95)},
+        {"p99", percentile(0.99)},
+        {"max", samples.back()}
+    };
+}
+
+// Startup time up to the first frame, with the share spent creating shader
+// programs (compiling on a cold start, loading cached binaries otherwise)
+nlohmann::json reportStartup(double startupMs) {
+    const ShaderUtils::ShaderLoadStats& shaders = ShaderUtils::getShaderLoadStats();
+    std::cout << "Startup took " << startupMs << " ms (shaders " << shaders.totalMs << " ms, "
+              << shaders.cacheHits << "/" << shaders.programs << " programs from cache)" << std::endl;
+    return {
+        {"totalMs", startupMs},
+        {"shaderMs", shaders.totalMs},
+        {"shaderPrograms", shaders.programs},
+        {"shaderCacheHits", shaders.cacheHits}
+    };
+}
+
+// Fly a fixed camera path for a fixed number of frames on an offscreen
+// context, with no input, and write frame-time, chunk-load and meshing
+// statistics to reportPath. Every frame waits for the GPU (glFinish) so the
+// frame times include rendering.
+int runFlythroughBenchmark(const std::string& reportPath, int frameCount) {
+    PROFILE_THREAD_NAME("Main");
+    using Clock = std::chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    Clock::time_point startupStart = Clock::now();
+    OffscreenContext context;
+    if (!context.create(SCR_WIDTH, SCR_HEIGHT)) {
+        return -1;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)OffscreenContext::getProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD\n";
+        return -1;
+    }
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+
+    unsigned int texture = loadTextureAtlas();
+    VoxelRenderer voxelRenderer(config);
+    initVoxelRenderer(voxelRenderer, texture);
+    OcclusionCuller occlusionCuller(config.voxelScale);
+    if (!initSkybox()) {
+        return -1;
+    }
+    nlohmann::json startup = reportStartup(elapsedMs(startupStart, Clock::now()));
+
+    BasicBiome biome(config);
+    chunkManager = new ChunkManager(config);
+    chunkManager->init(biome);
+
+    // Load the area around the start of the path, far LOD meshes included,
+    // before timing frames
+    Clock::time_point loadStart = Clock::now();
+    chunkManager->updateChunks(benchmarkCameraPath(0.0f));
+    chunkManager->finishPendingMeshes();
+    syncChangedChunks(voxelRenderer, occlusionCuller);
+    double initialLoadMs = elapsedMs(loadStart, Clock::now());
+    chunkManager->resetStreamingStats();
+
+    glm::mat4 projection = glm::perspective(glm::radians(config.camera.fov),
+                                           (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 100.0f);
+    std::vector<double> frameTimesMs;
+    frameTimesMs.reserve(frameCount);
+    int shadowCascadeRenders = 0;
+    std::vector<size_t> shadowFacesDrawn(voxelRenderer.getShadowCascadeCount(), 0);  // Per cascade, over the run
+    std::vector<double> facesDrawn;  // Per frame, after visibility culling
+    std::vector<double> chunksOccluded;  // Per frame, by the occlusion culler
+
+    std::cout << "Running flythrough benchmark for " << frameCount << " frames..." << std::endl;
+    Clock::time_point runStart = Clock::now();
+    for (int frame = 0; frame < frameCount; frame++) {
+        PROFILE_FRAME_MARK();
+        PROFILE_SCOPE("Frame");
+        Clock::time_point frameStart = Clock::now();
+
+        // Look a little ahead along the path, slightly downwards
+        float t = static_cast<float>(frame) / std::max(frameCount - 1, 1);
+        glm::vec3 cameraPos = benchmarkCameraPath(t);
+        glm::vec3 lookTarget = benchmarkCameraPath(t + 0.02f);
+        if (glm::length(lookTarget - cameraPos) < 1e-3f) {
+            lookTarget = cameraPos + glm::vec3(1.0f, 0.0f, 0.0f);
+        }
+        lookTarget.y -= 4.0f;
+        glm::mat4 view = glm::lookAt(cameraPos, lookTarget, glm::vec3(0.0f, 1.0f, 0.0f));
+        if (config.performance.occlusionCulling) {
+            occlusionCuller.beginFrame(projection * view);
+        }
+
+        // The prefetcher sees the path as flown at a nominal 60 frames per second
+        float nextT = static_cast<float>(frame + 1) / std::max(frameCount - 1, 1);
+        glm::vec3 velocity = (benchmarkCameraPath(nextT) - cameraPos) * 60.0f;
+        chunkManager->updateChunks(cameraPos, velocity, lookTarget - cameraPos);
+        syncChangedChunks(voxelRenderer, occlusionCuller);
+        voxelRenderer.setVisibleChunks(occlusionCuller.cullChunks(chunkManager->findVisibleChunks(cameraPos)));
+        voxelRenderer.setCameraPosition(cameraPos);
+
+        glClearColor(0.2f, 0.3f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        voxelRenderer.beginFrame(view, projection);
+        drawSkybox();
+        voxelRenderer.render();
+        shadowCascadeRenders += voxelRenderer.getShadowCascadesRendered();
+        for (int cascade = 0; cascade < voxelRenderer.getShadowCascadeCount(); cascade++) {
+            shadowFacesDrawn[cascade] += voxelRenderer.getShadowFacesDrawn(cascade);
+        }
+        facesDrawn.push_back(static_cast<double>(voxelRenderer.getDrawnFaceCount()));
+        chunksOccluded.push_back(static_cast<double>(occlusionCuller.getChunksCulled()));
+
+        context.swapBuffers();
+        glFinish();
+        frameTimesMs.push_back(elapsedMs(frameStart, Clock::now()));
+    }
+    double runMs = elapsedMs(runStart, Clock::now());
+
+    const ChunkStreamingStats& stats = chunkManager->getStreamingStats();
+    std::vector<double> loadLatencyMs;
+    for (uint64_t latencyNs : stats.loadLatencyNs) {
+        loadLatencyMs.push_back(latencyNs / 1.0e6);
+    }
+    double meshingSeconds = stats.meshingNs / 1.0e9;
+
+    nlohmann::json report = {
+        {"frames", frameCount},
+        {"totalMs", runMs},
+        {"startup", startup},
+        {"initialLoadMs", initialLoadMs},
+        {"frameTimeMs", summarizeSamples(frameTimesMs)},
+        {"shadowCascadeRenders", shadowCascadeRenders},
+        {"shadowFacesDrawnPerCascade", shadowFacesDrawn},
+        {"facesResident", voxelRenderer.getFaceCount()},
+        {"facesDrawn", summarizeSamples(facesDrawn)},
+        {"chunksOccluded", summarizeSamples(chunksOccluded)},
+        {"chunkLoad", {
+            {"chunksLoaded", stats.chunksLoaded},
+            {"emptyChunksLoaded", stats.emptyChunksLoaded},
+            {"generationMs", stats.generationNs / 1.0e6},
+            {"latencyMs", summarizeSamples(loadLatencyMs)}
+        }},
+        {"prefetch", {
+            {"chunksPrefetched", stats.chunksPrefetched},
+            {"readyInTime", stats.prefetchHits},
+            {"loadedOnDemand", stats.prefetchMisses},
+            {"wasted", stats.prefetchWasted},
+            {"hitRate", stats.prefetchHits + stats.prefetchMisses > 0 ?
+                static_cast<double>(stats.prefetchHits) / (stats.prefetchHits + stats.prefetchMisses) : 0.0}
+        }},
+        {"residency", {
+            {"viewDistance", chunkManager->getResidencyGovernor().getViewDistance()},
+            {"shrinks", chunkManager->getResidencyGovernor().getShrinkCount()},
+            {"grows", chunkManager->getResidencyGovernor().getGrowCount()},
+            {"trackedMB", chunkManager->getResidencyGovernor().getTrackedBytes() / (1024.0 * 1024.0)}
+        }},
+        {"meshing", {
+            {"meshesBuilt", stats.meshesBuilt},
+            {"facesMeshed", stats.meshedFaces},
+            {"totalMs", stats.meshingNs / 1.0e6},
+            {"meshesPerSecond", meshingSeconds > 0.0 ? stats.meshesBuilt / meshingSeconds : 0.0},
+            {"facesPerSecond", meshingSeconds > 0.0 ? stats.meshedFaces / meshingSeconds : 0.0}
+        }},
+        {"context", {
+            {"resolution", {SCR_WIDTH, SCR_HEIGHT}},
+            {"voxelScale", VOXEL_SCALE},
+            {"glRenderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER))},
+            {"glVersion", reinterpret_cast<const char*>(glGetString(GL_VERSION))}
+        }}
+    };
+
+    delete chunkManager;
+    chunkManager = nullptr;
+    delete skyboxTexture;
+    skyboxProgram.release();
+    glDeleteVertexArrays(1, &skyboxVAO);
+    glDeleteBuffers(1, &skyboxVBO);
+
+    std::ofstream out(reportPath);
+    if (!out.is_open()) {
+        std::cerr << "Failed to write benchmark report to " << reportPath << std::endl;
+        return -1;
+    }
+    out << report.dump(2) << std::endl;
+    std::cout << "Benchmark report written to " << reportPath << " (frame time p50 "
+              << report["frameTimeMs"]["p50"].get<double>() << " ms, p99 "
+              << report["frameTimeMs"]["p99"].get<double>() << " ms)" << std::endl;
+    return 0;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    std::chrono::steady_clock::time_point startupStart = std::chrono::steady_clock::now();
+    std::string benchmarkReport;
+    int benchmarkFrames = BENCHMARK_DEFAULT_FRAMES;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--benchmark" && i + 1 < argc) {
+            benchmarkReport = argv[++i];
+        } else if (arg == "--frames" && i + 1 < argc) {
+            benchmarkFrames = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--benchmark report.json [--frames N]]" << std::endl;
+            return -1;
+        }
+    }
+    if (!benchmarkReport.empty()) {
+        return runFlythroughBenchmark(benchmarkReport, benchmarkFrames);
+    }
+
+    PROFILE_THREAD_NAME("Main");
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -259,43 +669,12 @@ int main()
     }
 
     // Load texture atlas
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    // Set texture wrapping/filtering options
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    int tx_width, tx_height, nrChannels;
-
-    unsigned char *data = stbi_load((std::string(ASSETS_DIR) + "/atlas.png").c_str(), &tx_width, &tx_height, &nrChannels, 0);
-    if (data)
-    {
-        if (nrChannels == 3)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tx_width, tx_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        else if (nrChannels == 4)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tx_width, tx_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        else
-            std::cerr << "Error: Unsupported number of channels in texture\n";
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        std::cerr << "Failed to load texture\n";
-    }
-    stbi_image_free(data);
+    unsigned int texture = loadTextureAtlas();
 
     // Initialize the VoxelRenderer
     VoxelRenderer voxelRenderer(config);
-    voxelRenderer.init();
-    voxelRenderer.setTextureAtlas(texture);
-
-    // Set lighting properties
-    voxelRenderer.setLightDir(glm::vec3(-0.2f, -1.0f, -0.3f));
-    voxelRenderer.setLightColor(glm::vec3(1.0f, 1.0f, 1.0f));
-    voxelRenderer.setAmbientStrength(0.4f);
+    initVoxelRenderer(voxelRenderer, texture);
+    OcclusionCuller occlusionCuller(config.voxelScale);
 
     // Create and setup the biome
     BasicBiome biome(config);
@@ -321,37 +700,21 @@ int main()
     SystemUsageAsync usageAsync;
 
     // Initialize skybox
-    glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-
-    // Create and compile skybox shader
-    skyboxShader = createShaderProgram("Shaders/skybox.vert", "Shaders/skybox.frag");
-    std::string skyboxDir = std::string(ASSETS_DIR) + "/Clouds/" + config.skyname;
-
-    skyboxTexture = new CubemapTexture(
-        skyboxDir + "/px.png", // +X
-        skyboxDir + "/nx.png", // -X
-        skyboxDir + "/py.png", // +Y
-        skyboxDir + "/ny.png", // -Y
-        skyboxDir + "/pz.png", // +Z
-        skyboxDir + "/nz.png"  // -Z
-    );
-    if (!skyboxTexture->Load()) {
-        std::cerr << "Failed to load skybox textures!" << std::endl;
+    if (!initSkybox()) {
         return -1;
     }
 
     // Stats for chunk system
     int chunksLoaded = 0;
-    int totalVoxels = 0;
+
+    reportStartup(std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - startupStart).count());
 
     while (!glfwWindowShouldClose(window))
     {
+        PROFILE_FRAME_MARK();
+        PROFILE_SCOPE("Frame");
+        
         float currentFrame = (float)glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
@@ -376,18 +739,22 @@ int main()
         // Process user input
         processInput(window);
         
-        // Update player movement based on key states
-        if (moveForward)
-            player->moveForward(deltaTime);
-        if (moveBackward)
-            player->moveBackward(deltaTime);
-        if (moveLeft)
-            player->moveLeft(deltaTime);
-        if (moveRight)
-            player->moveRight(deltaTime);
-        
-        // Update player physics
-        player->update(deltaTime);
+        {
+            PROFILE_SCOPE("PlayerMovement");
+            
+            // Update player movement based on key states
+            if (moveForward)
+                player->moveForward(deltaTime);
+            if (moveBackward)
+                player->moveBackward(deltaTime);
+            if (moveLeft)
+                player->moveLeft(deltaTime);
+            if (moveRight)
+                player->moveRight(deltaTime);
+            
+            // Update player physics
+            player->update(deltaTime);
+        }
         
         // Get player position for camera view and chunk loading
         glm::vec3 playerPos = player->getPosition();
@@ -395,75 +762,137 @@ int main()
         // Pass camera position to voxel renderer for shadow calculations
         voxelRenderer.setCameraPosition(playerPos);
 
+        // Get view matrix from player
+        glm::mat4 view = player->getViewMatrix();
+        glm::mat4 projection = glm::perspective(glm::radians(config.camera.fov), 
+                                               (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 100.0f);
+
+        // The camera is final now, so the occluders can be rasterized on the
+        // culler's thread while the chunks update
+        if (config.performance.occlusionCulling) {
+            occlusionCuller.beginFrame(projection * view);
+        }
+
         // Blue background
         glClearColor(0.2f, 0.3f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Update chunk loading based on player position
-        chunkManager->updateChunks(playerPos);
+        // Update chunk loading based on player position, and load ahead
+        // along where the player is heading
+        chunkManager->updateChunks(playerPos, player->getMovementVelocity(), player->getFrontVector());
+        syncChangedChunks(voxelRenderer, occlusionCuller);
         
-        // Get all visible voxels from loaded chunks
-        std::vector<Voxel> voxelsToRender = chunkManager->getVisibleVoxels();
+        // Skip chunks the camera cannot see through caves and terrain, or
+        // that are outside the view or hidden behind near terrain
+        voxelRenderer.setVisibleChunks(
+            occlusionCuller.cullChunks(chunkManager->findVisibleChunks(player->getCameraPosition())));
         
         // Update stats
         chunksLoaded = 0;
-        totalVoxels = voxelsToRender.size();
 
-        // Get view matrix from player
-        glm::mat4 view = player->getViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(config.camera.fov), 
-                                               (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 100.0f);
+        // Upload this frame's camera and light values for every pass
+        voxelRenderer.beginFrame(view, projection);
 
         // Draw skybox first
-        glDepthFunc(GL_LEQUAL);
-        glUseProgram(skyboxShader);
-        // Remove translation from view matrix for skybox
-        glm::mat4 skyboxView = glm::mat4(glm::mat3(view));
-        glUniformMatrix4fv(glGetUniformLocation(skyboxShader, "view"), 1, GL_FALSE, glm::value_ptr(skyboxView));
-        glUniformMatrix4fv(glGetUniformLocation(skyboxShader, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        
-        glBindVertexArray(skyboxVAO);
-        skyboxTexture->Bind(GL_TEXTURE0);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS);
+        drawSkybox();
 
         // Render the voxels using the VoxelRenderer
-        voxelRenderer.render(voxelsToRender, view, projection);
+        voxelRenderer.render();
 
         // GUI
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::GetIO().FontGlobalScale = 2.5f;
-        ImGui::NewFrame();
-
-        float fps = 1.0f / deltaTime;
-        ImGui::SetNextWindowSize(ImVec2(600, 400), ImGuiCond_Always);
-        ImGui::Begin("Performance");
-        ImGui::Text("FPS: %.1f", fps);
-        ImGui::Text("Frame Time: %.2f ms", deltaTime * 1000.0f);
-        ImGui::PlotLines("Frame Time (ms)", frameTimes.data(), NUM_SAMPLES, frameIndex, nullptr, 0.0f, 50.0f, ImVec2(0, 80));
-        ImGui::Text("GPU Usage: %.1d MB", usage.getGpuMemoryUsageMB());
-        ImGui::Text("RAM Usage: %ld MB", usage.getRamUsageMB());
-        ImGui::Text("CPU Usage: %.1f%%", usageAsync.getCpuUsagePercent());
-        ImGui::Separator();
-        ImGui::Text("Chunks: %d", chunksLoaded);
-        ImGui::Text("Voxels: %d", totalVoxels);
-        ImGui::Separator();
+        {
+            PROFILE_SCOPE("ImGui");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::GetIO().FontGlobalScale = 2.5f;
+            ImGui::NewFrame();
+
+            float fps = 1.0f / deltaTime;
+            ImGui::SetNextWindowSize(ImVec2(600, 400), ImGuiCond_Always);
+            ImGui::Begin("Performance");
+            ImGui::Text("FPS: %.1f", fps);
+            ImGui::Text("Frame Time: %.2f ms", deltaTime * 1000.0f);
+            ImGui::PlotLines("Frame Time (ms)", frameTimes.data(), NUM_SAMPLES, frameIndex, nullptr, 0.0f, 50.0f, ImVec2(0, 80));
+            ImGui::Text("GPU Usage: %.1d MB", usage.getGpuMemoryUsageMB());
+            ImGui::Text("RAM Usage: %ld MB (peak %ld MB)", usage.getRamUsageMB(), usage.getPeakRamUsageMB());
+            ImGui::Text("CPU Usage: %.1f%%", usageAsync.getCpuUsagePercent());
+            ImGui::Separator();
+            ImGui::Text("Chunks: %d", chunksLoaded);
+            ImGui::Text("Faces: %zu drawn of %zu", voxelRenderer.getDrawnFaceCount(), voxelRenderer.getFaceCount());
+            ImGui::Text("Occlusion: %zu of %zu chunks culled, %zu occluders", occlusionCuller.getChunksCulled(),
+                        occlusionCuller.getChunksTested(), occlusionCuller.getOccludersDrawn());
+            ImGui::Text("Translucent chunks re-sorted: %d", voxelRenderer.getTranslucentChunksSorted());
+            ImGui::Text("Shadow cascades redrawn: %d", voxelRenderer.getShadowCascadesRendered());
+            ImGui::Separator();
         
-        // Player information
-        ImGui::Text("Player Position: (%.1f, %.1f, %.1f)", 
-                   playerPos.x, playerPos.y, playerPos.z);
-        ImGui::Text("On Ground: %s", player->isOnGround() ? "Yes" : "No");
-        ImGui::Text("Controls: WASD to move, Space to jump, R to respawn");
+            // Player information
+            ImGui::Text("Player Position: (%.1f, %.1f, %.1f)", 
+                       playerPos.x, playerPos.y, playerPos.z);
+            ImGui::Text("On Ground: %s", player->isOnGround() ? "Yes" : "No");
+            ImGui::Text("Controls: WASD to move, Space to jump, R to respawn, P to export profile");
         
-        ImGui::End();
+            ImGui::End();
+
+            // Live per-subsystem memory accounting
+            ImGui::Begin("Memory");
+            ImGui::Text("Resident: %.1f MB (peak %.1f MB)",
+                        MemoryTracker::getResidentBytes() / (1024.0 * 1024.0),
+                        MemoryTracker::getPeakResidentBytes() / (1024.0 * 1024.0));
+            if (ImGui::BeginTable("MemoryTags", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                ImGui::TableSetupColumn("Subsystem");
+                ImGui::TableSetupColumn("Current (MB)");
+                ImGui::TableSetupColumn("Peak (MB)");
+                ImGui::TableSetupColumn("Allocations");
+                ImGui::TableHeadersRow();
+                for (int i = 0; i < static_cast<int>(MemoryTag::Count); i++) {
+                    MemoryTag tag = static_cast<MemoryTag>(i);
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(MemoryTracker::getTagName(tag));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", MemoryTracker::getBytes(tag) / (1024.0 * 1024.0));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.2f", MemoryTracker::getPeakBytes(tag) / (1024.0 * 1024.0));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(MemoryTracker::getAllocationCount(tag)));
+                }
+                ImGui::EndTable();
+            }
+            ImGui::Text("[M] dump to %s", MEMORY_REPORT_FILE.c_str());
+            ImGui::End();
+
+            // What the memory budget governor did to the view, newest first
+            const ResidencyGovernor& governor = chunkManager->getResidencyGovernor();
+            ImGui::Begin("Residency");
+            ImGui::Text("View distance: %d of %d chunks, LOD rings at %d and %d", governor.getViewDistance(),
+                        governor.getMaxViewDistance(), governor.getHalfResolutionDistance(),
+                        governor.getQuarterResolutionDistance());
+            if (governor.getBudgetBytes() > 0) {
+                ImGui::Text("Tracked: %.1f MB of %.1f MB budget%s", governor.getTrackedBytes() / (1024.0 * 1024.0),
+                            governor.getBudgetBytes() / (1024.0 * 1024.0),
+                            governor.isOverBudget() ? ", over: prefetch paused" : "");
+            } else {
+                ImGui::Text("Tracked: %.1f MB, no budget", governor.getTrackedBytes() / (1024.0 * 1024.0));
+            }
+            const auto& decisions = governor.getRecentDecisions();
+            for (auto it = decisions.rbegin(); it != decisions.rend(); ++it) {
+                ImGui::Text("%s %d -> %d at %.1f MB, %llu updates ago", ResidencyGovernor::getActionName(it->action),
+                            it->fromDistance, it->toDistance, it->trackedBytes / (1024.0 * 1024.0),
+                            static_cast<unsigned long long>(governor.getUpdateCount() - it->update));
+            }
+            ImGui::End();
+
+            drawProfilerWindow(PROFILE_TRACE_FILE);
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("SwapBuffers");
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
     }
 
     ImGui_ImplOpenGL3_Shutdown();
@@ -474,6 +903,7 @@ int main()
     delete player;
     delete chunkManager;
     delete skyboxTexture;
+    skyboxProgram.release();
     
     glDeleteVertexArrays(1, &skyboxVAO);
     glDeleteBuffers(1, &skyboxVBO);
@@ -20,15 +20,13 @@ public:
     
     virtual ~Model() = default;
 
-    // Get all voxels in world space
-    virtual std::vector<Voxel> getVoxels() const {
-        std::vector<Voxel> worldVoxels;
+    // Append all voxels in world space to out
+    virtual void appendVoxels(std::vector<Voxel>& out) const {
         for (const auto& voxel : voxels) {
             // Scale first, then translate
             glm::vec3 worldPos = position + (voxel.position * scale);
-            worldVoxels.emplace_back(worldPos, voxel.blockId);
+            out.emplace_back(worldPos, voxel.blockId);
         }
-        return worldVoxels;
     }
 
     void setPosition(const glm::vec3& pos) { position = pos; }
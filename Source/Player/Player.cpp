@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include "../Utils/Profiler.h"
 
 Player::Player(ChunkManager* chunkManager, float playerHeight, float playerWidth) 
     : chunkManager(chunkManager),
@@ -9,6 +10,8 @@ Player::Player(ChunkManager* chunkManager, float playerHeight, float playerWidth
       yaw(0.0f),
       pitch(0.0f),
       velocity(0.0f, 0.0f, 0.0f),
+      movementVelocity(0.0f, 0.0f, 0.0f),
+      lastUpdatePosition(0.0f, 0.0f, 0.0f),
       gravity(20.0f),
       jumpForce(8.0f),
       onGround(false),
@@ -24,6 +27,7 @@ Player::Player(ChunkManager* chunkManager, float playerHeight, float playerWidth
 
 void Player::setPosition(const glm::vec3& pos) {
     position = pos;
+    lastUpdatePosition = pos;  // A jump, not movement
 }
 
 glm::vec3 Player::getPosition() const {
@@ -84,6 +88,8 @@ void Player::jump() {
 }
 
 void Player::update(float deltaTime) {
+    PROFILE_FUNCTION();
+    
     // Apply gravity
     applyGravity(deltaTime);
     
@@ -104,14 +110,23 @@ void Player::update(float deltaTime) {
             velocity.y = 0;
         }
     }
+    
+    if (deltaTime > 0.0f) {
+        movementVelocity = (position - lastUpdatePosition) / deltaTime;
+    }
+    lastUpdatePosition = position;
 }
 
 glm::mat4 Player::getViewMatrix() const {
-    // Calculate camera position with height offset
-    glm::vec3 cameraPos = position + glm::vec3(0.0f, cameraHeightOffset, 0.0f);
+    glm::vec3 cameraPos = getCameraPosition();
     return glm::lookAt(cameraPos, cameraPos + front, up);
 }
 
+glm::vec3 Player::getCameraPosition() const {
+    // Eye position: the player position raised by the camera height offset
+    return position + glm::vec3(0.0f, cameraHeightOffset, 0.0f);
+}
+
 glm::vec3 Player::getFrontVector() const {
     return front;
 }
@@ -130,6 +145,7 @@ void Player::spawnRandomly(int maxAttempts) {
         // Fallback to a default position high in the air
         position = glm::vec3(0.0f, 50.0f, 0.0f);
     }
+    lastUpdatePosition = position;
 }
 
 bool Player::isOnGround() const {
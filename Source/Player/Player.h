@@ -28,8 +28,12 @@ public:
     // Physics update
     void update(float deltaTime);
     
+    // Distance moved over the last update per second, walking included
+    glm::vec3 getMovementVelocity() const { return movementVelocity; }
+    
     // Camera
     glm::mat4 getViewMatrix() const;
+    glm::vec3 getCameraPosition() const;
     glm::vec3 getFrontVector() const;
     glm::vec3 getUpVector() const;
     
@@ -43,6 +47,9 @@ public:
     // Check if the player is on the ground
     bool isOnGround() const;
     
+    // Check for collision with voxels at a hypothetical player position
+    bool checkCollision(const glm::vec3& pos) const;
+    
 private:
     // Position and orientation
     glm::vec3 position;
@@ -51,6 +58,8 @@ private:
     
     // Physics properties
     glm::vec3 velocity;
+    glm::vec3 movementVelocity;
+    glm::vec3 lastUpdatePosition;  // Where the last update left the player
     float gravity;
     float jumpForce;
     bool onGround;
@@ -76,9 +85,6 @@ private:
     // Recalculate the front, right and up vectors based on yaw and pitch
     void updateVectors();
     
-    // Check for collision with voxels
-    bool checkCollision(const glm::vec3& pos) const;
-    
     // Find a suitable spawn position
     bool findSafeSpawnPosition(glm::vec3& spawnPos, int maxAttempts);
     
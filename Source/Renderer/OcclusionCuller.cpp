@@ -0,0 +1,304 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "../Utils/Profiler.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE
+#endif
+
+namespace {
+    // Boxes reaching closer than this to the camera are never occluders and
+    // never culled; their projection is unreliable. Matches the near plane.
+    const float NEAR_DEPTH = 0.1f;
+    const float EMPTY_DEPTH = std::numeric_limits<float>::max();
+
+    struct ScreenPoint {
+        float x, y;
+    };
+
+    // Project the eight corners of a box to depth buffer pixels. Returns false
+    // if any corner is nearer than NEAR_DEPTH.
+    bool projectBox(const glm::mat4& viewProjection, const glm::vec3& minCorner, const glm::vec3& maxCorner,
+                    ScreenPoint* points, float& nearestDepth, float& farthestDepth) {
+        nearestDepth = EMPTY_DEPTH;
+        farthestDepth = 0.0f;
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec4 clip = viewProjection * glm::vec4((corner & 1) ? maxCorner.x : minCorner.x,
+                                                        (corner & 2) ? maxCorner.y : minCorner.y,
+                                                        (corner & 4) ? maxCorner.z : minCorner.z, 1.0f);
+            if (clip.w < NEAR_DEPTH) {
+                return false;
+            }
+            points[corner].x = (clip.x / clip.w * 0.5f + 0.5f) * OcclusionCuller::BUFFER_WIDTH;
+            points[corner].y = (clip.y / clip.w * 0.5f + 0.5f) * OcclusionCuller::BUFFER_HEIGHT;
+            nearestDepth = std::min(nearestDepth, clip.w);
+            farthestDepth = std::max(farthestDepth, clip.w);
+        }
+        return true;
+    }
+
+    float cross(const ScreenPoint& o, const ScreenPoint& a, const ScreenPoint& b) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+
+    // Counter-clockwise convex hull of a box's projected corners (monotone
+    // chain). Returns the number of hull points written to `hull`.
+    int convexHull(ScreenPoint* points, int count, ScreenPoint* hull) {
+        std::sort(points, points + count, [](const ScreenPoint& a, const ScreenPoint& b) {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        });
+        int size = 0;
+        for (int i = 0; i < count; i++) {
+            while (size >= 2 && cross(hull[size - 2], hull[size - 1], points[i]) <= 0.0f) {
+                size--;
+            }
+            hull[size++] = points[i];
+        }
+        int lowerSize = size + 1;
+        for (int i = count - 2; i >= 0; i--) {
+            while (size >= lowerSize && cross(hull[size - 2], hull[size - 1], points[i]) <= 0.0f) {
+                size--;
+            }
+            hull[size++] = points[i];
+        }
+        return size - 1;  // The first point is repeated at the end
+    }
+
+    // depth[x] = min(depth[x], value) for x in [first, last]
+    void fillSpan(float* row, int first, int last, float value) {
+        int x = first;
+#ifdef OCCLUSION_CULLER_SSE
+        __m128 fill = _mm_set1_ps(value);
+        for (; x + 4 <= last + 1; x += 4) {
+            _mm_storeu_ps(row + x, _mm_min_ps(_mm_loadu_ps(row + x), fill));
+        }
+#endif
+        for (; x <= last; x++) {
+            row[x] = std::min(row[x], value);
+        }
+    }
+}
+
+OcclusionCuller::OcclusionCuller(float voxelScale) : voxelScale(voxelScale) {
+    size_t offset = 0;
+    for (int level = 0; level < MIP_LEVELS; level++) {
+        mipOffsets.push_back(offset);
+        offset += static_cast<size_t>(mipWidth(level)) * mipHeight(level);
+    }
+    depthMips.assign(offset, EMPTY_DEPTH);
+}
+
+void OcclusionCuller::setChunkOccluders(int chunkX, int chunkY, int chunkZ, const std::vector<Chunk::OccluderBox>& boxes) {
+    // Voxel positions are cube centres, so a box starts half a voxel early
+    glm::vec3 origin = glm::vec3(chunkX * Chunk::CHUNK_SIZE_X, chunkY * Chunk::CHUNK_SIZE_Y, chunkZ * Chunk::CHUNK_SIZE_Z) * voxelScale -
+                       glm::vec3(voxelScale * 0.5f);
+    ChunkOccluders& worldBoxes = pendingOccluders[ChunkCoord(chunkX, chunkY, chunkZ)];
+    worldBoxes.clear();
+    for (const auto& box : boxes) {
+        worldBoxes.push_back({origin + glm::vec3(box.minX, box.minY, box.minZ) * voxelScale,
+                              origin + glm::vec3(box.maxX, box.maxY, box.maxZ) * voxelScale});
+    }
+}
+
+void OcclusionCuller::removeChunk(int chunkX, int chunkY, int chunkZ) {
+    pendingOccluders[ChunkCoord(chunkX, chunkY, chunkZ)].clear();
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& frameViewProjection) {
+    // The previous frame's job may not have been waited for
+    rasterThread.waitIdle();
+
+    for (auto& [coords, boxes] : pendingOccluders) {
+        if (boxes.empty()) {
+            occluders.erase(coords);
+        } else {
+            occluders[coords] = std::move(boxes);
+        }
+    }
+    pendingOccluders.clear();
+
+    viewProjection = frameViewProjection;
+    frameStarted = true;
+    rasterThread.submit([this]() { rasterizeOccluders(); });
+}
+
+void OcclusionCuller::rasterizeOccluders() {
+    PROFILE_FUNCTION();
+
+    std::fill(depthMips.begin(), depthMips.begin() + BUFFER_WIDTH * BUFFER_HEIGHT, EMPTY_DEPTH);
+    occludersDrawn = 0;
+    for (const auto& [coords, boxes] : occluders) {
+        for (const auto& box : boxes) {
+            rasterizeBox(box);
+        }
+    }
+    buildDepthMips();
+}
+
+void OcclusionCuller::rasterizeBox(const WorldBox& box) {
+    ScreenPoint corners[8];
+    float nearestDepth, farthestDepth;
+    if (!projectBox(viewProjection, box.minCorner, box.maxCorner, corners, nearestDepth, farthestDepth)) {
+        return;
+    }
+
+    float minY = corners[0].y, maxY = corners[0].y;
+    float minX = corners[0].x, maxX = corners[0].x;
+    for (const auto& corner : corners) {
+        minX = std::min(minX, corner.x);
+        maxX = std::max(maxX, corner.x);
+        minY = std::min(minY, corner.y);
+        maxY = std::max(maxY, corner.y);
+    }
+    if (maxX < 1.0f || minX > BUFFER_WIDTH - 1.0f || maxY < 1.0f || minY > BUFFER_HEIGHT - 1.0f) {
+        return;  // Covers no whole pixel of the view
+    }
+
+    ScreenPoint hull[9];
+    int hullSize = convexHull(corners, 8, hull);
+    if (hullSize < 3) {
+        return;
+    }
+
+    // Edge functions a * x + b * y + c, positive inside the hull
+    struct Edge {
+        float a, b, c;
+    };
+    Edge edges[8];
+    for (int i = 0; i < hullSize; i++) {
+        const ScreenPoint& p = hull[i];
+        const ScreenPoint& q = hull[(i + 1) % hullSize];
+        float a = p.y - q.y;
+        float b = q.x - p.x;
+        edges[i] = {a, b, -(a * p.x + b * p.y)};
+    }
+
+    // Fill the pixels lying entirely inside the outline. For each edge the
+    // row's worst corner is fixed by the sign of b, which leaves a bound on x.
+    int firstRow = std::max(0, static_cast<int>(std::floor(minY)));
+    int lastRow = std::min(BUFFER_HEIGHT - 1, static_cast<int>(std::ceil(maxY)) - 1);
+    bool drawn = false;
+    for (int row = firstRow; row <= lastRow; row++) {
+        float spanStart = 0.0f;
+        float spanEnd = BUFFER_WIDTH - 1.0f;
+        for (int i = 0; i < hullSize && spanStart <= spanEnd; i++) {
+            const Edge& edge = edges[i];
+            float rowValue = edge.b * static_cast<float>(edge.b >= 0.0f ? row : row + 1) + edge.c;
+            if (edge.a > 0.0f) {
+                spanStart = std::max(spanStart, std::ceil(-rowValue / edge.a));
+            } else if (edge.a < 0.0f) {
+                spanEnd = std::min(spanEnd, std::floor(-rowValue / edge.a) - 1.0f);
+            } else if (rowValue < 0.0f) {
+                spanEnd = -1.0f;
+            }
+        }
+        if (spanStart <= spanEnd) {
+            fillSpan(&depthMips[static_cast<size_t>(row) * BUFFER_WIDTH], static_cast<int>(spanStart),
+                     static_cast<int>(spanEnd), farthestDepth);
+            drawn = true;
+        }
+    }
+    occludersDrawn += drawn;
+}
+
+void OcclusionCuller::buildDepthMips() {
+    PROFILE_FUNCTION();
+
+    // Each texel keeps the farthest depth of the 2 x 2 texels below it
+    for (int level = 1; level < MIP_LEVELS; level++) {
+        const float* source = &depthMips[mipOffsets[level - 1]];
+        float* target = &depthMips[mipOffsets[level]];
+        int sourceWidth = mipWidth(level - 1);
+        int width = mipWidth(level);
+        for (int y = 0; y < mipHeight(level); y++) {
+            const float* row0 = source + static_cast<size_t>(2 * y) * sourceWidth;
+            const float* row1 = row0 + sourceWidth;
+            float* out = target + static_cast<size_t>(y) * width;
+            int x = 0;
+#ifdef OCCLUSION_CULLER_SSE
+            for (; x + 4 <= width; x += 4) {
+                __m128 left = _mm_max_ps(_mm_loadu_ps(row0 + 2 * x), _mm_loadu_ps(row1 + 2 * x));
+                __m128 right = _mm_max_ps(_mm_loadu_ps(row0 + 2 * x + 4), _mm_loadu_ps(row1 + 2 * x + 4));
+                __m128 even = _mm_shuffle_ps(left, right, _MM_SHUFFLE(2, 0, 2, 0));
+                __m128 odd = _mm_shuffle_ps(left, right, _MM_SHUFFLE(3, 1, 3, 1));
+                _mm_storeu_ps(out + x, _mm_max_ps(even, odd));
+            }
+#endif
+            for (; x < width; x++) {
+                out[x] = std::max(std::max(row0[2 * x], row0[2 * x + 1]), std::max(row1[2 * x], row1[2 * x + 1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isBoxVisible(const glm::vec3& minCorner, const glm::vec3& maxCorner) const {
+    ScreenPoint corners[8];
+    float nearestDepth, farthestDepth;
+    if (!projectBox(viewProjection, minCorner, maxCorner, corners, nearestDepth, farthestDepth)) {
+        return true;
+    }
+
+    float minX = corners[0].x, maxX = corners[0].x;
+    float minY = corners[0].y, maxY = corners[0].y;
+    for (const auto& corner : corners) {
+        minX = std::min(minX, corner.x);
+        maxX = std::max(maxX, corner.x);
+        minY = std::min(minY, corner.y);
+        maxY = std::max(maxY, corner.y);
+    }
+    if (maxX < 0.0f || minX > BUFFER_WIDTH || maxY < 0.0f || minY > BUFFER_HEIGHT) {
+        return false;  // Outside the view frustum
+    }
+
+    // Texels touched by the box's screen bounds, at the finest level where
+    // they span at most 2 x 2
+    int x0 = std::clamp(static_cast<int>(std::floor(minX)), 0, BUFFER_WIDTH - 1);
+    int x1 = std::clamp(static_cast<int>(std::floor(maxX)), 0, BUFFER_WIDTH - 1);
+    int y0 = std::clamp(static_cast<int>(std::floor(minY)), 0, BUFFER_HEIGHT - 1);
+    int y1 = std::clamp(static_cast<int>(std::floor(maxY)), 0, BUFFER_HEIGHT - 1);
+    int level = 0;
+    while (level < MIP_LEVELS - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+        level++;
+    }
+
+    const float* mip = &depthMips[mipOffsets[level]];
+    int width = mipWidth(level);
+    float occluderDepth = 0.0f;
+    for (int y = y0 >> level; y <= (y1 >> level); y++) {
+        for (int x = x0 >> level; x <= (x1 >> level); x++) {
+            occluderDepth = std::max(occluderDepth, mip[static_cast<size_t>(y) * width + x]);
+        }
+    }
+    return nearestDepth <= occluderDepth;
+}
+
+const std::vector<ChunkCoord>& OcclusionCuller::cullChunks(const std::vector<ChunkCoord>& candidates) {
+    PROFILE_FUNCTION();
+
+    chunksTested = 0;
+    chunksCulled = 0;
+    if (!frameStarted) {
+        culledChunks = candidates;
+        return culledChunks;
+    }
+    rasterThread.waitIdle();
+    frameStarted = false;
+
+    culledChunks.clear();
+    float halfVoxel = voxelScale * 0.5f;
+    const glm::ivec3 chunkSize(Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y, Chunk::CHUNK_SIZE_Z);
+    for (const ChunkCoord& coords : candidates) {
+        glm::vec3 minCorner = glm::vec3(coords * chunkSize) * voxelScale - glm::vec3(halfVoxel);
+        glm::vec3 maxCorner = minCorner + glm::vec3(chunkSize) * voxelScale;
+        chunksTested++;
+        if (isBoxVisible(minCorner, maxCorner)) {
+            culledChunks.push_back(coords);
+        } else {
+            chunksCulled++;
+        }
+    }
+    return culledChunks;
+}
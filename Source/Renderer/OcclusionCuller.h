@@ -0,0 +1,92 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+#include "../World/ChunkManager.h"
+#include "../Utils/ThreadPool.h"
+
+// Software occlusion culling for the main pass. The solid occluder boxes of
+// near full-resolution chunks are rasterized on a worker thread into a small
+// depth buffer, with a mip chain keeping the farthest depth of each texel's
+// area. Chunks whose bounds lie outside the view or behind that depth are
+// dropped from the draw list.
+//
+// Both steps are conservative: an occluder only covers the pixels its screen
+// outline covers completely, at the depth of its farthest corner, and a
+// chunk is tested with its nearest corner. Culling never removes a chunk
+// that could show a pixel.
+//
+// Has no OpenGL dependency; depths are view distances (clip w).
+class OcclusionCuller {
+public:
+    // Depth buffer resolution; it spans the whole view whatever its aspect
+    static const int BUFFER_WIDTH = 256;
+    static const int BUFFER_HEIGHT = 128;
+    static const int MIP_LEVELS = 8;  // Down to 2 x 1 texels
+
+    explicit OcclusionCuller(float voxelScale);
+
+    // Replace a chunk's occluder boxes (from its uploaded mesh), or drop them
+    // when it is unloaded. Changes take effect at the next beginFrame, so
+    // they are safe to make while a frame is being rasterized.
+    void setChunkOccluders(int chunkX, int chunkY, int chunkZ, const std::vector<Chunk::OccluderBox>& boxes);
+    void removeChunk(int chunkX, int chunkY, int chunkZ);
+
+    // Start rasterizing the occluders for this frame's camera on the worker
+    // thread. Call it as early in the frame as the camera is known, so the
+    // work overlaps the chunk update.
+    void beginFrame(const glm::mat4& viewProjection);
+
+    // Wait for the rasterization, then return the candidates with every
+    // hidden chunk removed. Without a beginFrame since the last call, the
+    // candidates are returned unchanged. The result is valid until the next
+    // call.
+    const std::vector<ChunkCoord>& cullChunks(const std::vector<ChunkCoord>& candidates);
+
+    // Statistics of the last frame
+    size_t getOccludersDrawn() const { return occludersDrawn; }
+    size_t getChunksTested() const { return chunksTested; }
+    size_t getChunksCulled() const { return chunksCulled; }
+
+private:
+    // Occluder boxes in world space
+    struct WorldBox {
+        glm::vec3 minCorner;
+        glm::vec3 maxCorner;
+    };
+    using ChunkOccluders = std::vector<WorldBox>;
+
+    float voxelScale;
+
+    // Read by the rasterizer; only changed between frames
+    std::unordered_map<ChunkCoord, ChunkOccluders, ChunkCoordHash> occluders;
+    // Changes made since the last beginFrame; an empty list removes the chunk
+    std::unordered_map<ChunkCoord, ChunkOccluders, ChunkCoordHash> pendingOccluders;
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    bool frameStarted = false;
+
+    // Depth of every mip level, level 0 first, row by row
+    std::vector<float> depthMips;
+    std::vector<size_t> mipOffsets;
+
+    std::vector<ChunkCoord> culledChunks;
+    size_t occludersDrawn = 0;
+    size_t chunksTested = 0;
+    size_t chunksCulled = 0;
+
+    // Declared last so the worker is joined before the buffers it writes go
+    ThreadPool rasterThread{1};
+
+    void rasterizeOccluders();
+    void rasterizeBox(const WorldBox& box);
+    void buildDepthMips();
+    bool isBoxVisible(const glm::vec3& minCorner, const glm::vec3& maxCorner) const;
+    static int mipWidth(int level) { return BUFFER_WIDTH >> level; }
+    static int mipHeight(int level) { return BUFFER_HEIGHT >> level; }
+};
+
+#endif // OCCLUSION_CULLER_H
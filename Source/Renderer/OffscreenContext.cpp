@@ -0,0 +1,142 @@
+#include "OffscreenContext.h"
+
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // Displays worth trying, best first: a GPU device without a window
+    // system, Mesa's surfaceless platform (llvmpipe), then the default display
+    std::vector<EGLDisplay> candidateDisplays() {
+        std::vector<EGLDisplay> displays;
+
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+            eglGetProcAddress("eglQueryDevicesEXT"));
+
+        if (getPlatformDisplay && queryDevices) {
+            EGLDeviceEXT devices[8];
+            EGLint deviceCount = 0;
+            if (queryDevices(8, devices, &deviceCount)) {
+                for (EGLint i = 0; i < deviceCount; i++) {
+                    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+                    if (display != EGL_NO_DISPLAY) {
+                        displays.push_back(display);
+                    }
+                }
+            }
+        }
+        if (getPlatformDisplay) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) {
+                displays.push_back(display);
+            }
+        }
+        EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display != EGL_NO_DISPLAY) {
+            displays.push_back(display);
+        }
+        return displays;
+    }
+}
+
+OffscreenContext::~OffscreenContext() {
+    destroy();
+}
+
+bool OffscreenContext::create(int width, int height) {
+    for (EGLDisplay candidate : candidateDisplays()) {
+        if (createOnDisplay(candidate, width, height)) {
+            return true;
+        }
+    }
+    std::cerr << "Failed to create an offscreen OpenGL 3.3 context (EGL error 0x"
+              << std::hex << eglGetError() << std::dec << ")" << std::endl;
+    return false;
+}
+
+bool OffscreenContext::createOnDisplay(void* candidate, int width, int height) {
+    EGLDisplay eglDisplay = static_cast<EGLDisplay>(candidate);
+    EGLint major = 0, minor = 0;
+    if (!eglInitialize(eglDisplay, &major, &minor)) {
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig eglConfig;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(eglDisplay, configAttribs, &eglConfig, 1, &configCount) || configCount == 0 ||
+        !eglBindAPI(EGL_OPENGL_API)) {
+        eglTerminate(eglDisplay);
+        return false;
+    }
+
+    const EGLint surfaceAttribs[] = {
+        EGL_WIDTH, width,
+        EGL_HEIGHT, height,
+        EGL_NONE
+    };
+    EGLSurface eglSurface = eglCreatePbufferSurface(eglDisplay, eglConfig, surfaceAttribs);
+    if (eglSurface == EGL_NO_SURFACE) {
+        eglTerminate(eglDisplay);
+        return false;
+    }
+
+    // Same context version as the windowed path
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext eglContext = eglCreateContext(eglDisplay, eglConfig, EGL_NO_CONTEXT, contextAttribs);
+    if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(eglDisplay, eglSurface, eglSurface, eglContext)) {
+        if (eglContext != EGL_NO_CONTEXT) {
+            eglDestroyContext(eglDisplay, eglContext);
+        }
+        eglDestroySurface(eglDisplay, eglSurface);
+        eglTerminate(eglDisplay);
+        return false;
+    }
+
+    display = eglDisplay;
+    surface = eglSurface;
+    context = eglContext;
+    std::cout << "Created offscreen EGL " << major << "." << minor << " context ("
+              << eglQueryString(eglDisplay, EGL_VENDOR) << ")" << std::endl;
+    return true;
+}
+
+void OffscreenContext::destroy() {
+    if (!display) {
+        return;
+    }
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglDestroySurface(display, surface);
+    eglTerminate(display);
+    display = surface = context = nullptr;
+}
+
+void OffscreenContext::swapBuffers() {
+    if (display) {
+        eglSwapBuffers(display, surface);
+    }
+}
+
+void* OffscreenContext::getProcAddress(const char* name) {
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
@@ -0,0 +1,35 @@
+#ifndef OFFSCREEN_CONTEXT_H
+#define OFFSCREEN_CONTEXT_H
+
+// Headless OpenGL 3.3 core context backed by an EGL pbuffer. Used by the
+// benchmark mode so it can run without a window system, e.g. on a build
+// host with only Mesa's llvmpipe.
+class OffscreenContext {
+public:
+    OffscreenContext() = default;
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // Create a width x height pbuffer context and make it current.
+    // Prints the reason and returns false if no EGL display can provide one.
+    bool create(int width, int height);
+    void destroy();
+
+    void swapBuffers();
+
+    // GL entry point loader, suitable for gladLoadGLLoader
+    static void* getProcAddress(const char* name);
+
+private:
+    // EGLDisplay / EGLSurface / EGLContext, kept opaque so EGL (and the
+    // platform headers it pulls in) stays out of this header
+    void* display = nullptr;
+    void* surface = nullptr;
+    void* context = nullptr;
+
+    bool createOnDisplay(void* candidate, int width, int height);
+};
+
+#endif // OFFSCREEN_CONTEXT_H
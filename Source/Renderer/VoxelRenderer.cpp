@@ -0,0 +1,590 @@
+#include "VoxelRenderer.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>  // For glm::lookAt, glm::ortho
+#include <glm/gtx/transform.hpp>         // Additional transformation functions
+#include "../Utils/ShaderUtils.h"
+#include "../Utils/Profiler.h"
+#include "../World/BlockDatabase.h"
+
+// Block face tile table in std140 layout: one vec4 holds the tiles of two
+// faces (xy, zw), so each block takes FACE_COUNT / 2 vec4s
+static std::vector<glm::vec4> buildBlockTileTable() {
+    const BlockDatabase& blockDatabase = BlockDatabase::getInstance();
+    std::vector<glm::vec4> table(BlockDatabase::MAX_BLOCK_TYPES * BlockDatabase::FACE_COUNT / 2, glm::vec4(0.0f));
+    for (unsigned int id = 0; id < blockDatabase.getBlockTypeCount(); id++) {
+        for (unsigned int face = 0; face < BlockDatabase::FACE_COUNT; face += 2) {
+            glm::vec2 first = blockDatabase.getFaceTile(id, static_cast<BlockFace>(face));
+            glm::vec2 second = blockDatabase.getFaceTile(id, static_cast<BlockFace>(face + 1));
+            table[(id * BlockDatabase::FACE_COUNT + face) / 2] = glm::vec4(first, second);
+        }
+    }
+    return table;
+}
+
+// Outward normals in BlockFace order, as in packed_face.glsl
+static const glm::vec3 FACE_NORMALS[BlockDatabase::FACE_COUNT] = {
+    glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+    glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+    glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f)
+};
+
+static_assert(sizeof(glm::mat4) == 64 && sizeof(glm::vec4) == 16, "FrameUniforms assumes tightly packed glm types");
+
+std::string VoxelRenderer::getFrameUniformsDeclaration() {
+    return "#define SHADOW_CASCADE_COUNT " + std::to_string(SHADOW_CASCADE_COUNT) + "\n"
+           "layout(std140) uniform FrameUniforms {\n"
+           "    mat4 view;\n"
+           "    mat4 projection;\n"
+           "    mat4 lightSpaceMatrices[SHADOW_CASCADE_COUNT];\n"
+           "    vec3 lightDir;\n"
+           "    float ambientStrength;\n"
+           "    vec3 lightColor;\n"
+           "    vec3 viewPos;\n"
+           "    vec4 cascadeRadii;\n"
+           "};";
+}
+
+// Constructor and Destructor
+VoxelRenderer::VoxelRenderer(Config& config) : VAO(0), textureAtlasId(0), depthMapFBO(0), depthMap(0), localconfig(config) {
+    // Set the configuration
+    localconfig = config;
+}
+VoxelRenderer::~VoxelRenderer() {
+    for (auto& [coords, mesh] : chunkMeshes) {
+        glDeleteBuffers(1, &mesh.buffer);
+    }
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteFramebuffers(1, &depthMapFBO);
+    glDeleteTextures(1, &depthMap);
+    glDeleteBuffers(1, &blockTileUBO);
+    glDeleteBuffers(1, &frameUniformUBO);
+}
+
+void VoxelRenderer::initShadowMap() {
+    // Create framebuffer
+    glGenFramebuffers(1, &depthMapFBO);
+    
+    // One depth layer per cascade
+    glGenTextures(1, &depthMap);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, SHADOW_RESOLUTION, SHADOW_RESOLUTION,
+                 SHADOW_CASCADE_COUNT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    shadowMapMemory.resize(static_cast<size_t>(SHADOW_RESOLUTION) * SHADOW_RESOLUTION *
+                           SHADOW_CASCADE_COUNT * sizeof(float));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+    
+    // Attach the first cascade to check completeness; each cascade attaches
+    // its own layer when it is rendered
+    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "Framebuffer is not complete!" << std::endl;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Initialization
+void VoxelRenderer::init() {
+    // Create the main shader program of every render layer
+    std::string packedFacePrelude = getPackedFacePrelude();
+    std::string voxelPrelude = "#define MAX_BLOCK_TYPES " + std::to_string(BlockDatabase::MAX_BLOCK_TYPES) + "\n" +
+                               getFrameUniformsDeclaration() + "\n" + packedFacePrelude;
+    const char* layerDefines[RENDER_LAYER_COUNT] = {"", "#define ALPHA_TEST\n", "#define TRANSLUCENT\n"};
+    for (unsigned int layer = 0; layer < RENDER_LAYER_COUNT; layer++) {
+        LayerProgram& layerProgram = layerPrograms[layer];
+        layerProgram.program.load(
+            std::string(SHADER_DIR) + "/voxel_vertex.glsl",
+            std::string(SHADER_DIR) + "/voxel_fragment.glsl",
+            layerDefines[layer] + voxelPrelude
+        );
+        layerProgram.chunkOriginLocation = layerProgram.program.getUniformLocation("chunkOrigin");
+        layerProgram.cellSizeLocation = layerProgram.program.getUniformLocation("cellSize");
+        
+        // Uniforms that never change are set once here
+        layerProgram.program.use();
+        glUniform1i(layerProgram.program.getUniformLocation("textureAtlas"), 0);
+        glUniform1i(layerProgram.program.getUniformLocation("shadowMap"), 1);
+        glUniform1f(layerProgram.program.getUniformLocation("atlasSize"), 16.0f);
+        glUniform1f(layerProgram.program.getUniformLocation("voxelScale"), localconfig.voxelScale);
+        layerProgram.program.bindUniformBlock("BlockTiles", BLOCK_TILE_BINDING);
+        layerProgram.program.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+    }
+    glUseProgram(0);
+    
+    // Upload the block face tile table once; the shader reads it with a
+    // single indexed fetch per vertex
+    std::vector<glm::vec4> tileTable = buildBlockTileTable();
+    glGenBuffers(1, &blockTileUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, blockTileUBO);
+    glBufferData(GL_UNIFORM_BUFFER, tileTable.size() * sizeof(glm::vec4), tileTable.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BLOCK_TILE_BINDING, blockTileUBO);
+    blockTileMemory.resize(tileTable.size() * sizeof(glm::vec4));
+    
+    // Frame uniforms, rewritten once per frame by beginFrame()
+    glGenBuffers(1, &frameUniformUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, frameUniformUBO);
+    frameUniformMemory.resize(sizeof(FrameUniforms));
+    
+    // Create shadow mapping shader program
+    shadowProgram.load(
+        std::string(SHADER_DIR) + "/shadow_mapping.vert",
+        std::string(SHADER_DIR) + "/shadow_mapping.frag",
+        getFrameUniformsDeclaration() + "\n" + packedFacePrelude
+    );
+    shadowProgram.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+    shadowCascadeIndexLocation = shadowProgram.getUniformLocation("cascadeIndex");
+    shadowChunkOriginLocation = shadowProgram.getUniformLocation("chunkOrigin");
+    shadowCellSizeLocation = shadowProgram.getUniformLocation("cellSize");
+    shadowProgram.use();
+    glUniform1f(shadowProgram.getUniformLocation("voxelScale"), localconfig.voxelScale);
+    glUseProgram(0);
+
+    // Initialize shadow mapping
+    initShadowMap();
+    
+    // Quad corners are generated in the vertex shader, so the only attribute
+    // is the per-instance packed face. Its buffer is set per chunk draw.
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+    glBindVertexArray(0);
+}
+
+std::string VoxelRenderer::getPackedFacePrelude() const {
+    // Bit layout from PackedFace.h, then the shared decoding functions
+    std::ostringstream prelude;
+    prelude << "#define PACKED_X_SHIFT " << PackedFaceLayout::X_SHIFT << "u\n"
+            << "#define PACKED_Y_SHIFT " << PackedFaceLayout::Y_SHIFT << "u\n"
+            << "#define PACKED_Z_SHIFT " << PackedFaceLayout::Z_SHIFT << "u\n"
+            << "#define PACKED_FACE_SHIFT " << PackedFaceLayout::FACE_SHIFT << "u\n"
+            << "#define PACKED_BLOCK_SHIFT " << PackedFaceLayout::BLOCK_SHIFT << "u\n"
+            << "#define PACKED_LIGHT_SHIFT " << PackedFaceLayout::LIGHT_SHIFT << "u\n"
+            << "#define PACKED_X_MASK " << ((1u << PackedFaceLayout::X_BITS) - 1) << "u\n"
+            << "#define PACKED_Y_MASK " << ((1u << PackedFaceLayout::Y_BITS) - 1) << "u\n"
+            << "#define PACKED_Z_MASK " << ((1u << PackedFaceLayout::Z_BITS) - 1) << "u\n"
+            << "#define PACKED_FACE_MASK " << ((1u << PackedFaceLayout::FACE_BITS) - 1) << "u\n"
+            << "#define PACKED_BLOCK_MASK " << ((1u << PackedFaceLayout::BLOCK_BITS) - 1) << "u\n"
+            << "#define PACKED_LIGHT_MASK " << ((1u << PackedFaceLayout::LIGHT_BITS) - 1) << "u\n";
+    
+    std::string path = std::string(SHADER_DIR) + "/packed_face.glsl";
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << "\n";
+        return prelude.str();
+    }
+    prelude << file.rdbuf();
+    return prelude.str();
+}
+
+void VoxelRenderer::uploadChunkMesh(int chunkX, int chunkY, int chunkZ, const Chunk::Mesh& chunkMesh, int lodLevel) {
+    const std::vector<PackedFace>& faces = chunkMesh.faces;
+    if (faces.empty()) {
+        removeChunkMesh(chunkX, chunkY, chunkZ);
+        return;
+    }
+    
+    ChunkMesh& mesh = chunkMeshes[ChunkCoord(chunkX, chunkY, chunkZ)];
+    if (mesh.buffer == 0) {
+        glGenBuffers(1, &mesh.buffer);
+    }
+    mesh.origin = glm::vec3(chunkX * Chunk::CHUNK_SIZE_X, chunkY * Chunk::CHUNK_SIZE_Y, chunkZ * Chunk::CHUNK_SIZE_Z) *
+                  localconfig.voxelScale;
+    mesh.cellSize = static_cast<float>(Chunk::getLodCellSize(lodLevel));
+    mesh.layerStarts = chunkMesh.layerStarts;
+    mesh.visible = true;
+    totalFaceCount = totalFaceCount - mesh.faceCount + faces.size();
+    mesh.faceCount = static_cast<GLsizei>(faces.size());
+    
+    // Only reallocate if the buffer needs to grow
+    size_t bytes = faces.size() * sizeof(PackedFace);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.buffer);
+    if (bytes > mesh.capacity) {
+        glBufferData(GL_ARRAY_BUFFER, bytes, faces.data(), GL_STATIC_DRAW);
+        mesh.capacity = bytes;
+        mesh.memory.resize(bytes);
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, faces.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    // Translucent faces are kept to be sorted for the camera, starting now
+    uint32_t translucentStart = mesh.layerStarts[static_cast<unsigned int>(RenderLayer::TRANSLUCENT)];
+    mesh.translucentFaces.assign(faces.begin() + translucentStart, faces.end());
+    mesh.translucentMemory.resize(mesh.translucentFaces.capacity() * sizeof(PackedFace));
+    if (!mesh.translucentFaces.empty()) {
+        sortTranslucentFaces(mesh);
+    }
+}
+
+void VoxelRenderer::removeChunkMesh(int chunkX, int chunkY, int chunkZ) {
+    auto it = chunkMeshes.find(ChunkCoord(chunkX, chunkY, chunkZ));
+    if (it == chunkMeshes.end()) {
+        return;
+    }
+    glDeleteBuffers(1, &it->second.buffer);
+    totalFaceCount -= it->second.faceCount;
+    chunkMeshes.erase(it);
+}
+
+void VoxelRenderer::setVisibleChunks(const std::vector<ChunkCoord>& visible) {
+    for (auto& [coords, mesh] : chunkMeshes) {
+        mesh.visible = false;
+    }
+    for (const ChunkCoord& coords : visible) {
+        auto it = chunkMeshes.find(coords);
+        if (it != chunkMeshes.end()) {
+            it->second.visible = true;
+        }
+    }
+}
+
+void VoxelRenderer::sortTranslucentFaces(ChunkMesh& mesh) {
+    // Sort key: squared distance from the centre of the camera's voxel to
+    // the face centre, in voxels from the chunk origin
+    glm::vec3 eye = glm::vec3(eyeCell) - mesh.origin / localconfig.voxelScale;
+    uint32_t translucentStart = mesh.layerStarts[static_cast<unsigned int>(RenderLayer::TRANSLUCENT)];
+    keyedTranslucent.clear();
+    for (PackedFace face : mesh.translucentFaces) {
+        glm::vec3 local(static_cast<float>((face >> PackedFaceLayout::X_SHIFT) & ((1u << PackedFaceLayout::X_BITS) - 1)),
+                        static_cast<float>((face >> PackedFaceLayout::Y_SHIFT) & ((1u << PackedFaceLayout::Y_BITS) - 1)),
+                        static_cast<float>((face >> PackedFaceLayout::Z_SHIFT) & ((1u << PackedFaceLayout::Z_BITS) - 1)));
+        uint32_t side = (face >> PackedFaceLayout::FACE_SHIFT) & ((1u << PackedFaceLayout::FACE_BITS) - 1);
+        glm::vec3 center = (local + 0.5f + 0.5f * FACE_NORMALS[side]) * mesh.cellSize - 0.5f;
+        glm::vec3 toEye = center - eye;
+        keyedTranslucent.emplace_back(glm::dot(toEye, toEye), face);
+    }
+    std::sort(keyedTranslucent.begin(), keyedTranslucent.end(), [](const std::pair<float, PackedFace>& a, const std::pair<float, PackedFace>& b) {
+        return a.first > b.first;
+    });
+    for (size_t i = 0; i < keyedTranslucent.size(); i++) {
+        mesh.translucentFaces[i] = keyedTranslucent[i].second;
+    }
+    mesh.sortedCell = eyeCell;
+    
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, translucentStart * sizeof(PackedFace),
+                    mesh.translucentFaces.size() * sizeof(PackedFace), mesh.translucentFaces.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VoxelRenderer::sortStaleTranslucentFaces() {
+    PROFILE_FUNCTION();
+    
+    staleTranslucent.clear();
+    for (auto& [coords, mesh] : chunkMeshes) {
+        if (!mesh.translucentFaces.empty() && mesh.sortedCell != eyeCell) {
+            glm::vec3 toEye = mesh.origin - eyePosition;
+            staleTranslucent.emplace_back(glm::dot(toEye, toEye), &mesh);
+        }
+    }
+    size_t count = std::min(staleTranslucent.size(), static_cast<size_t>(MAX_TRANSLUCENT_SORTS_PER_FRAME));
+    std::partial_sort(staleTranslucent.begin(), staleTranslucent.begin() + count, staleTranslucent.end(),
+        [](const std::pair<float, ChunkMesh*>& a, const std::pair<float, ChunkMesh*>& b) { return a.first < b.first; });
+    for (size_t i = 0; i < count; i++) {
+        sortTranslucentFaces(*staleTranslucent[i].second);
+    }
+    translucentChunksSorted = static_cast<int>(count);
+}
+
+void VoxelRenderer::sortDrawOrder() {
+    drawOrder.clear();
+    for (const auto& [coords, mesh] : chunkMeshes) {
+        if (mesh.visible) {
+            drawOrder.push_back(&mesh);
+        }
+    }
+    glm::vec3 halfChunk = glm::vec3(Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y, Chunk::CHUNK_SIZE_Z) * (0.5f * localconfig.voxelScale);
+    auto distanceToEye = [&](const ChunkMesh* mesh) {
+        glm::vec3 toEye = mesh->origin + halfChunk - eyePosition;
+        return glm::dot(toEye, toEye);
+    };
+    std::sort(drawOrder.begin(), drawOrder.end(), [&](const ChunkMesh* a, const ChunkMesh* b) {
+        return distanceToEye(a) < distanceToEye(b);
+    });
+}
+
+void VoxelRenderer::drawFaces(uint32_t first, GLsizei count) {
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(PackedFace), (void*)(first * sizeof(PackedFace)));
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+}
+
+size_t VoxelRenderer::drawChunkLayer(const LayerProgram& layerProgram, const ChunkMesh& mesh, RenderLayer layer) {
+    unsigned int index = static_cast<unsigned int>(layer);
+    uint32_t first = mesh.layerStarts[index];
+    GLsizei count = static_cast<GLsizei>(mesh.layerStarts[index + 1] - first);
+    if (count == 0) {
+        return 0;
+    }
+    glUniform3fv(layerProgram.chunkOriginLocation, 1, &mesh.origin[0]);
+    glUniform1f(layerProgram.cellSizeLocation, mesh.cellSize);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.buffer);
+    drawFaces(first, count);
+    return count;
+}
+
+size_t VoxelRenderer::drawTranslucentLayer() {
+    PROFILE_FUNCTION();
+    
+    const LayerProgram& layerProgram = layerPrograms[static_cast<unsigned int>(RenderLayer::TRANSLUCENT)];
+    layerProgram.program.use();
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    
+    // Chunks back to front
+    size_t facesDrawn = 0;
+    glBindVertexArray(VAO);
+    for (auto it = drawOrder.rbegin(); it != drawOrder.rend(); ++it) {
+        facesDrawn += drawChunkLayer(layerProgram, **it, RenderLayer::TRANSLUCENT);
+    }
+    glBindVertexArray(0);
+    
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    return facesDrawn;
+}
+
+glm::mat4 VoxelRenderer::getLightRotation() const {
+    glm::vec3 direction = glm::normalize(lightDir);
+    glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    return glm::lookAt(glm::vec3(0.0f), direction, up);
+}
+
+void VoxelRenderer::getLightSpaceBounds(const glm::mat4& lightRotation, const glm::vec3& minCorner, const glm::vec3& maxCorner,
+                                        glm::vec3& boundsMin, glm::vec3& boundsMax) const {
+    boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 point((corner & 1) ? maxCorner.x : minCorner.x,
+                        (corner & 2) ? maxCorner.y : minCorner.y,
+                        (corner & 4) ? maxCorner.z : minCorner.z);
+        glm::vec3 projected = glm::vec3(lightRotation * glm::vec4(point, 1.0f));
+        boundsMin = glm::min(boundsMin, projected);
+        boundsMax = glm::max(boundsMax, projected);
+    }
+}
+
+bool VoxelRenderer::overlapsShadowCascade(int cascade, const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+    // The cascade's ortho box, in light space: its radius across the light
+    // and the depth range along it, around the snapped centre
+    glm::vec3 center = shadowCascades[cascade].snappedCenter;
+    glm::vec3 halfExtent(SHADOW_CASCADE_RADII[cascade], SHADOW_CASCADE_RADII[cascade], SHADOW_DEPTH_RANGE / 2.0f);
+    return glm::all(glm::greaterThanEqual(boundsMax, center - halfExtent)) &&
+           glm::all(glm::lessThanEqual(boundsMin, center + halfExtent));
+}
+
+void VoxelRenderer::invalidateShadowRegion(const glm::vec3& minCorner, const glm::vec3& maxCorner) {
+    glm::vec3 boundsMin, boundsMax;
+    getLightSpaceBounds(getLightRotation(), minCorner, maxCorner, boundsMin, boundsMax);
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+        if (overlapsShadowCascade(i, boundsMin, boundsMax)) {
+            shadowCascades[i].dirty = true;
+        }
+    }
+}
+
+void VoxelRenderer::placeShadowCascades() {
+    if (lightDir != shadowLightDir) {
+        for (ShadowCascade& cascade : shadowCascades) {
+            cascade.dirty = true;
+        }
+        shadowLightDir = lightDir;
+    }
+    
+    // Cascades are centred on the camera, so turning the camera never moves
+    // them. Their centres are snapped to whole texels in light space (and to
+    // coarse steps along the light), so shadows do not shimmer and a cascade
+    // keeps its contents until the camera has moved at least one texel.
+    glm::mat4 lightRotation = getLightRotation();
+    glm::vec3 cameraLightSpace = glm::vec3(lightRotation * glm::vec4(cameraPos, 1.0f));
+    
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+        ShadowCascade& cascade = shadowCascades[i];
+        float radius = SHADOW_CASCADE_RADII[i];
+        float texelSize = 2.0f * radius / SHADOW_RESOLUTION;
+        glm::vec3 snappedCenter(std::floor(cameraLightSpace.x / texelSize) * texelSize,
+                                std::floor(cameraLightSpace.y / texelSize) * texelSize,
+                                std::floor(cameraLightSpace.z / SHADOW_DEPTH_STEP) * SHADOW_DEPTH_STEP);
+        if (!cascade.dirty && snappedCenter == cascade.snappedCenter) {
+            continue;
+        }
+        
+        // The light looks down -Z, so the centre's depth is -z
+        float centerDepth = -snappedCenter.z;
+        glm::mat4 lightProjection = glm::ortho(
+            snappedCenter.x - radius, snappedCenter.x + radius,
+            snappedCenter.y - radius, snappedCenter.y + radius,
+            centerDepth - SHADOW_DEPTH_RANGE / 2.0f, centerDepth + SHADOW_DEPTH_RANGE / 2.0f);
+        cascade.lightSpaceMatrix = lightProjection * lightRotation;
+        cascade.snappedCenter = snappedCenter;
+        cascade.dirty = true;  // Rendered by the next render() call
+    }
+}
+
+void VoxelRenderer::renderShadowCascades() {
+    PROFILE_FUNCTION();
+    
+    shadowCascadesRendered = 0;
+    bool passStarted = false;
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+        shadowFacesDrawn[i] = 0;
+    }
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+        if (!shadowCascades[i].dirty) {
+            continue;
+        }
+        if (!passStarted) {
+            buildShadowDrawLists();
+            glViewport(0, 0, SHADOW_RESOLUTION, SHADOW_RESOLUTION);
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            shadowProgram.use();
+            
+            // Enable polygon offset for shadow acne reduction
+            glEnable(GL_POLYGON_OFFSET_FILL);
+            glPolygonOffset(4.0f, 4.0f);
+            passStarted = true;
+        }
+        renderShadowCascade(i);
+        shadowCascades[i].dirty = false;
+    }
+    
+    if (passStarted) {
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
+
+void VoxelRenderer::buildShadowDrawLists() {
+    PROFILE_FUNCTION();
+    
+    for (auto& drawList : shadowDrawLists) {
+        drawList.clear();
+    }
+    
+    // Voxel positions are cube centres, so a chunk's box reaches half a
+    // voxel below its origin
+    glm::mat4 lightRotation = getLightRotation();
+    glm::vec3 chunkExtent = glm::vec3(Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y, Chunk::CHUNK_SIZE_Z) * localconfig.voxelScale;
+    float halfVoxel = localconfig.voxelScale * 0.5f;
+    for (const auto& [coords, mesh] : chunkMeshes) {
+        glm::vec3 minCorner = mesh.origin - halfVoxel;
+        glm::vec3 boundsMin, boundsMax;
+        getLightSpaceBounds(lightRotation, minCorner, minCorner + chunkExtent, boundsMin, boundsMax);
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+            if (shadowCascades[i].dirty && overlapsShadowCascade(i, boundsMin, boundsMax)) {
+                shadowDrawLists[i].push_back(&mesh);
+            }
+        }
+    }
+}
+
+void VoxelRenderer::renderShadowCascade(int cascade) {
+    PROFILE_FUNCTION();
+    
+    // The cascade matrices live in the frame uniform block
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0, cascade);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glUniform1i(shadowCascadeIndexLocation, cascade);
+    glBindVertexArray(VAO);
+    for (const ChunkMesh* mesh : shadowDrawLists[cascade]) {
+        glUniform3fv(shadowChunkOriginLocation, 1, &mesh->origin[0]);
+        glUniform1f(shadowCellSizeLocation, mesh->cellSize);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->buffer);
+        drawFaces(0, mesh->faceCount);
+        shadowFacesDrawn[cascade] += mesh->faceCount;
+    }
+    glBindVertexArray(0);
+    shadowCascadesRendered++;
+}
+
+void VoxelRenderer::beginFrame(const glm::mat4& view, const glm::mat4& projection) {
+    PROFILE_FUNCTION();
+    
+    placeShadowCascades();
+    
+    eyePosition = glm::vec3(glm::inverse(view)[3]);
+    eyeCell = glm::ivec3(glm::floor(eyePosition / localconfig.voxelScale + 0.5f));
+    
+    FrameUniforms frame = {};
+    frame.view = view;
+    frame.projection = projection;
+    for (int i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+        frame.lightSpaceMatrices[i] = shadowCascades[i].lightSpaceMatrix;
+        frame.cascadeRadii[i] = SHADOW_CASCADE_RADII[i];
+    }
+    frame.lightDir = lightDir;
+    frame.ambientStrength = ambientStrength;
+    frame.lightColor = lightColor;
+    frame.viewPos = cameraPos;
+    
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+// Rendering the voxels
+void VoxelRenderer::render() {
+    PROFILE_FUNCTION();
+    
+    if (!layerPrograms[0].program.isValid() || textureAtlasId == 0) {
+        std::cerr << "Error: VoxelRenderer not properly initialized or texture not set.\n";
+        return;
+    }
+
+    // First render pass: refresh the shadow cascades that moved or changed
+    renderShadowCascades();
+    
+    // Second render pass: render scene with shadows. Camera and light values
+    // come from the frame uniform block written in beginFrame().
+    glViewport(0, 0, localconfig.window.width, localconfig.window.height);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textureAtlasId);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+
+    // Opaque then cut-out faces, nearest chunks first so the depth test
+    // rejects as many hidden fragments as it can
+    sortDrawOrder();
+    size_t facesDrawn = 0;
+    glBindVertexArray(VAO);
+    for (RenderLayer layer : {RenderLayer::OPAQUE, RenderLayer::CUTOUT}) {
+        const LayerProgram& layerProgram = layerPrograms[static_cast<unsigned int>(layer)];
+        layerProgram.program.use();
+        for (const ChunkMesh* mesh : drawOrder) {
+            facesDrawn += drawChunkLayer(layerProgram, *mesh, layer);
+        }
+    }
+    glBindVertexArray(0);
+    
+    // Blended faces last, farthest first
+    sortStaleTranslucentFaces();
+    facesDrawn += drawTranslucentLayer();
+    drawnFaceCount = facesDrawn;
+}
+
+// Set texture atlas
+void VoxelRenderer::setTextureAtlas(unsigned int textureId) {
+    textureAtlasId = textureId;
+}
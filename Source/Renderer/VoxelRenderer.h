@@ -0,0 +1,206 @@
+#ifndef VOXEL_RENDERER_H
+#define VOXEL_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../World/ChunkManager.h"
+#include "../World/BlockDatabase.h"
+#include "../World/PackedFace.h"
+#include "../Utils/ConfigReader.h"
+#include "../Utils/MemoryTracker.h"
+#include "../Utils/ShaderUtils.h"
+
+class VoxelRenderer {
+public:
+    VoxelRenderer(Config& config);
+    ~VoxelRenderer();
+
+    void init();
+    
+    // Write this frame's camera and light values into the shared frame
+    // uniform block. Call once per frame before any pass that reads it
+    // (the skybox included), after the camera position and light are set.
+    void beginFrame(const glm::mat4& view, const glm::mat4& projection);
+    void render();
+    void setTextureAtlas(unsigned int textureId);
+    
+    // Chunk meshes are kept in one GPU buffer per chunk and only uploaded
+    // when the chunk is remeshed; removing a chunk frees its buffer.
+    // lodLevel is the mesh's Chunk detail level, which sets its cell size.
+    void uploadChunkMesh(int chunkX, int chunkY, int chunkZ, const Chunk::Mesh& mesh, int lodLevel);
+    void removeChunkMesh(int chunkX, int chunkY, int chunkZ);
+    
+    // Restrict the main pass to these chunks (from ChunkManager's
+    // visibility search) until the next call. Shadow casters are not culled.
+    // Chunks uploaded since the last call are drawn.
+    void setVisibleChunks(const std::vector<ChunkCoord>& visible);
+    
+    // Faces held in GPU buffers, and faces drawn by the last main pass
+    size_t getFaceCount() const { return totalFaceCount; }
+    size_t getDrawnFaceCount() const { return drawnFaceCount; }
+    
+    // Chunks whose translucent faces the last render() re-sorted
+    int getTranslucentChunksSorted() const { return translucentChunksSorted; }
+
+    // Add lighting setters
+    void setLightDir(const glm::vec3& dir) { lightDir = dir; }
+    void setLightColor(const glm::vec3& color) { lightColor = color; }
+    void setAmbientStrength(float strength) { ambientStrength = strength; }
+    void setCameraPosition(const glm::vec3& pos) { cameraPos = pos; }
+    
+    // Re-render the shadow cascades overlapping this world-space box on the
+    // next frame. Call it for every chunk whose mesh changed or was unloaded.
+    void invalidateShadowRegion(const glm::vec3& minCorner, const glm::vec3& maxCorner);
+    
+    // Cascades re-rendered by the last render() call (0 on static frames),
+    // and the faces it drew into each one (0 for cascades it kept)
+    int getShadowCascadesRendered() const { return shadowCascadesRendered; }
+    int getShadowCascadeCount() const { return SHADOW_CASCADE_COUNT; }
+    size_t getShadowFacesDrawn(int cascade) const { return shadowFacesDrawn[cascade]; }
+    
+    // Binding point of the "FrameUniforms" block, and its GLSL declaration to
+    // pass as a prelude to any other program that reads it
+    static const unsigned int FRAME_UNIFORMS_BINDING = 1;
+    static std::string getFrameUniformsDeclaration();
+    Config& localconfig;
+
+private:
+    // Main pass program of each render layer (BlockDatabase's RenderLayer),
+    // built from the same sources with different defines
+    struct LayerProgram {
+        ShaderUtils::ShaderProgram program;
+        int chunkOriginLocation = -1;
+        int cellSizeLocation = -1;
+    };
+    std::array<LayerProgram, RENDER_LAYER_COUNT> layerPrograms;
+    ShaderUtils::ShaderProgram shadowProgram;  // Depth-only shadow map pass
+    int shadowCascadeIndexLocation = -1;
+    int shadowChunkOriginLocation = -1;
+    int shadowCellSizeLocation = -1;
+    unsigned int VAO;
+    unsigned int textureAtlasId;
+    
+    // Block face tile table (std140 uniform block, uploaded once in init)
+    static const unsigned int BLOCK_TILE_BINDING = 0;
+    unsigned int blockTileUBO = 0;
+    
+    // Cascaded shadow maps, one depth texture array layer per cascade. The
+    // cascades are centred on the camera with growing radii and each one is
+    // only re-rendered when it moves by a texel or its contents change.
+    static const int SHADOW_CASCADE_COUNT = 3;  // At most 4, see FrameUniforms::cascadeRadii
+    static constexpr float SHADOW_CASCADE_RADII[SHADOW_CASCADE_COUNT] = {12.0f, 36.0f, 100.0f};
+    static const unsigned int SHADOW_RESOLUTION = 2048;
+    static constexpr float SHADOW_DEPTH_RANGE = 200.0f;  // Depth covered along the light
+    static constexpr float SHADOW_DEPTH_STEP = 8.0f;     // Snap step of the depth range
+    
+    struct ShadowCascade {
+        glm::mat4 lightSpaceMatrix = glm::mat4(1.0f);
+        glm::vec3 snappedCenter = glm::vec3(0.0f);  // Light-space centre
+        bool dirty = true;
+    };
+    
+    unsigned int depthMapFBO;
+    unsigned int depthMap;
+    ShadowCascade shadowCascades[SHADOW_CASCADE_COUNT];
+    glm::vec3 shadowLightDir = glm::vec3(0.0f);  // lightDir the cascades were rendered with
+    int shadowCascadesRendered = 0;
+    size_t shadowFacesDrawn[SHADOW_CASCADE_COUNT] = {};
+    
+    // Per-frame values in std140 layout; must match getFrameUniformsDeclaration()
+    struct FrameUniforms {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 lightSpaceMatrices[SHADOW_CASCADE_COUNT];
+        glm::vec3 lightDir;
+        float ambientStrength;
+        glm::vec3 lightColor;
+        float padding0;
+        glm::vec3 viewPos;
+        float padding1;
+        glm::vec4 cascadeRadii;  // One cascade per component
+    };
+    unsigned int frameUniformUBO = 0;
+    
+    // Packed faces of one chunk, drawn as instances of a 6-vertex quad with
+    // the chunk origin and cell size as per-draw uniforms. The faces are in
+    // Chunk::Mesh order, by render layer.
+    struct ChunkMesh {
+        unsigned int buffer = 0;
+        size_t capacity = 0;  // Bytes; grown as needed and never shrunk
+        GLsizei faceCount = 0;
+        glm::vec3 origin = glm::vec3(0.0f);
+        float cellSize = 1.0f;  // Voxels per side of one packed position
+        std::array<uint32_t, RENDER_LAYER_COUNT + 1> layerStarts{};
+        bool visible = true;
+        TrackedAllocation memory{MemoryTag::GpuMemory};
+        
+        // CPU copy of the translucent faces, re-sorted back to front whenever
+        // the camera has moved to another voxel
+        std::vector<PackedFace> translucentFaces;
+        glm::ivec3 sortedCell = glm::ivec3(0);  // Camera voxel of the last sort
+        TrackedAllocation translucentMemory{MemoryTag::GpuBufferMirror};
+    };
+    std::unordered_map<ChunkCoord, ChunkMesh, ChunkCoordHash> chunkMeshes;
+    size_t totalFaceCount = 0;
+    size_t drawnFaceCount = 0;
+    
+    // Camera position and voxel of the current frame, from beginFrame()
+    glm::vec3 eyePosition = glm::vec3(0.0f);
+    glm::ivec3 eyeCell = glm::ivec3(0);
+    
+    // Visible chunks, nearest first; rebuilt every render()
+    std::vector<const ChunkMesh*> drawOrder;
+    
+    // Stale translucent chunks are re-sorted nearest first, at most this
+    // many per frame, so crossing a voxel border never stalls one frame
+    static const int MAX_TRANSLUCENT_SORTS_PER_FRAME = 8;
+    int translucentChunksSorted = 0;
+    
+    // Chunks sorted for another camera voxel, nearest first; rebuilt every
+    // render() like drawOrder
+    std::vector<std::pair<float, ChunkMesh*>> staleTranslucent;
+    
+    // Translucent faces of the chunk being sorted, keyed by distance to the
+    // eye; kept between sorts so sorting allocates nothing once warm
+    std::vector<std::pair<float, PackedFace>> keyedTranslucent;
+    
+    // Chunks whose box overlaps each cascade's box in light space; rebuilt
+    // for the cascades being re-rendered
+    std::array<std::vector<const ChunkMesh*>, SHADOW_CASCADE_COUNT> shadowDrawLists;
+    
+    // GPU memory accounting
+    TrackedAllocation shadowMapMemory{MemoryTag::GpuMemory};
+    TrackedAllocation blockTileMemory{MemoryTag::GpuMemory};
+    TrackedAllocation frameUniformMemory{MemoryTag::GpuMemory};
+    
+    // Lighting properties
+    glm::vec3 lightDir = glm::vec3(-0.2f, -1.0f, -0.3f);
+    glm::vec3 lightColor = glm::vec3(1.0f, 1.0f, 1.0f);
+    float ambientStrength = 0.4f;
+    glm::vec3 cameraPos; // Make cameraPos a member variable
+    
+    // Helper functions
+    void initShadowMap();
+    glm::mat4 getLightRotation() const;
+    void placeShadowCascades();
+    void renderShadowCascades();
+    void renderShadowCascade(int cascade);
+    void buildShadowDrawLists();
+    void getLightSpaceBounds(const glm::mat4& lightRotation, const glm::vec3& minCorner, const glm::vec3& maxCorner,
+                             glm::vec3& boundsMin, glm::vec3& boundsMax) const;
+    bool overlapsShadowCascade(int cascade, const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+    void drawFaces(uint32_t first, GLsizei count);
+    size_t drawChunkLayer(const LayerProgram& layerProgram, const ChunkMesh& mesh, RenderLayer layer);
+    size_t drawTranslucentLayer();
+    void sortDrawOrder();
+    void sortTranslucentFaces(ChunkMesh& mesh);
+    void sortStaleTranslucentFaces();
+    std::string getPackedFacePrelude() const;
+};
+
+#endif // VOXEL_RENDERER_H
@@ -35,6 +35,23 @@ Config loadConfig(const std::string& filename) {
     config.performance.numSamples = j["performance"]["numSamples"];
     config.performance.vsync = j["performance"]["vsync"];
     config.performance.targetFPS = j["performance"]["targetFPS"];
+    config.performance.workerThreads = j["performance"]["workerThreads"];
+    config.performance.occlusionCulling = j["performance"]["occlusionCulling"];
+    config.performance.chunkPoolHugePages = j["performance"]["chunkPoolHugePages"];
+    
+    config.lod.halfResolutionDistance = j["lod"]["halfResolutionDistance"];
+    config.lod.quarterResolutionDistance = j["lod"]["quarterResolutionDistance"];
+    
+    config.streaming.viewDistance = j["streaming"]["viewDistance"];
+    config.streaming.minViewDistance = j["streaming"]["minViewDistance"];
+    config.streaming.verticalViewDistance = j["streaming"]["verticalViewDistance"];
+    config.streaming.memoryBudgetMB = j["streaming"]["memoryBudgetMB"];
+    
+    config.prefetch.enabled = j["prefetch"]["enabled"];
+    config.prefetch.lookAheadSeconds = j["prefetch"]["lookAheadSeconds"];
+    config.prefetch.coneAngle = j["prefetch"]["coneAngle"];
+    config.prefetch.chunksPerUpdate = j["prefetch"]["chunksPerUpdate"];
+    config.prefetch.maxChunks = j["prefetch"]["maxChunks"];
     
     config.voxelScale = j["voxelScale"];
     config.skyname = j["skyname"];
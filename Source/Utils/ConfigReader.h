@@ -30,6 +30,9 @@ struct PerformanceConfig {
     int numSamples;
     bool vsync;
     int targetFPS;
+    int workerThreads;  // Background meshing threads; 0 picks one per spare core
+    bool occlusionCulling;  // Cull chunks hidden behind near terrain
+    bool chunkPoolHugePages;  // Ask for huge pages to back the chunk pool
 };
 
 struct GridConfig {
@@ -38,6 +41,35 @@ struct GridConfig {
     int vox_maxHeight;
 };
 
+// Chunk distances (in chunks from the camera's chunk) past which chunks are
+// meshed at 2x and at 4x coarser resolution, at the configured view
+// distance; they shrink along with the view
+struct LodConfig {
+    int halfResolutionDistance;
+    int quarterResolutionDistance;
+};
+
+// Chunks kept loaded around the camera: every column within the view
+// distance, with the chunks holding its surface and those within the
+// vertical view distance of the camera's. With a memory budget, the view
+// distance and LOD rings shrink while chunk storage, meshes and GPU buffers
+// would exceed it, and grow back when there is room (see ResidencyGovernor).
+struct StreamingConfig {
+    int viewDistance;          // In chunks from the camera's chunk, at most
+    int minViewDistance;       // The budget never shrinks the view below this
+    int verticalViewDistance;  // Chunks above and below the camera's
+    int memoryBudgetMB;        // 0 for no budget
+};
+
+// Loading chunks ahead of the camera, along where it is heading
+struct PrefetchConfig {
+    bool enabled;
+    float lookAheadSeconds;  // How far ahead the path is extrapolated
+    float coneAngle;         // Half-angle in degrees by which the path widens
+    int chunksPerUpdate;     // Chunks generated ahead per updateChunks call
+    int maxChunks;           // Chunks held ahead of the view area at most
+};
+
 struct FullscreenConfig {
     bool enabled;
     bool borderless;
@@ -49,6 +81,9 @@ struct Config {
     CameraConfig camera;
     PerformanceConfig performance;
     GridConfig gridConfig;
+    LodConfig lod;
+    StreamingConfig streaming;
+    PrefetchConfig prefetch;
     float voxelScale;
     FullscreenConfig fullscreen;
     std::string skyname;
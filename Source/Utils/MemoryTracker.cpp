@@ -0,0 +1,104 @@
+#include "MemoryTracker.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <fstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace MemoryTracker {
+    namespace {
+        const size_t TAG_COUNT = static_cast<size_t>(MemoryTag::Count);
+
+        struct TagCounters {
+            std::atomic<int64_t> bytes{0};
+            std::atomic<int64_t> peakBytes{0};
+            std::atomic<uint64_t> allocations{0};
+        };
+
+        TagCounters counters[TAG_COUNT];
+
+        const char* tagNames[TAG_COUNT] = {
+            "chunkBlocks",
+            "chunkMeshes",
+            "gpuBufferMirror",
+            "gpuMemory",
+            "generationScratch",
+            "chunkSnapshots",
+            "chunkColumns"
+        };
+
+        TagCounters& countersFor(MemoryTag tag) {
+            return counters[static_cast<size_t>(tag)];
+        }
+    }
+
+    void track(MemoryTag tag, int64_t bytes) {
+        TagCounters& tagCounters = countersFor(tag);
+        int64_t current = tagCounters.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        if (bytes > 0) {
+            tagCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+            int64_t peak = tagCounters.peakBytes.load(std::memory_order_relaxed);
+            while (current > peak && !tagCounters.peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    int64_t getBytes(MemoryTag tag) {
+        return countersFor(tag).bytes.load(std::memory_order_relaxed);
+    }
+
+    int64_t getPeakBytes(MemoryTag tag) {
+        return countersFor(tag).peakBytes.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getAllocationCount(MemoryTag tag) {
+        return countersFor(tag).allocations.load(std::memory_order_relaxed);
+    }
+
+    const char* getTagName(MemoryTag tag) {
+        return tag < MemoryTag::Count ? tagNames[static_cast<size_t>(tag)] : "unknown";
+    }
+
+    size_t getResidentBytes() {
+        // Second field of statm is the resident page count; unlike ru_maxrss
+        // it drops again when memory is returned to the OS
+        std::ifstream statm("/proc/self/statm");
+        size_t totalPages = 0, residentPages = 0;
+        if (!(statm >> totalPages >> residentPages)) {
+            return 0;
+        }
+        return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    size_t getPeakResidentBytes() {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            return static_cast<size_t>(usage.ru_maxrss) * 1024; // ru_maxrss is in kilobytes
+        }
+        return 0;
+    }
+
+    std::string toJson() {
+        nlohmann::json j;
+        j["residentBytes"] = getResidentBytes();
+        j["peakResidentBytes"] = getPeakResidentBytes();
+        for (size_t i = 0; i < TAG_COUNT; i++) {
+            MemoryTag tag = static_cast<MemoryTag>(i);
+            j["tags"][getTagName(tag)] = {
+                {"bytes", getBytes(tag)},
+                {"peakBytes", getPeakBytes(tag)},
+                {"allocations", getAllocationCount(tag)}
+            };
+        }
+        return j.dump(2);
+    }
+
+    bool dumpJson(const std::string& path) {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << toJson() << "\n";
+        return out.good();
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Subsystems whose memory is accounted separately
+enum class MemoryTag {
+    ChunkBlocks,        // Per-chunk block and light storage
+    ChunkMeshes,        // Per-chunk instance meshes kept on the CPU
+    GpuBufferMirror,    // CPU copies of data uploaded to GPU buffers
+    GpuMemory,          // Bytes allocated in GL buffers and textures
+    GenerationScratch,  // Temporary buffers used by terrain generation
+    ChunkSnapshots,     // Voxel snapshots read by worker threads, spares included
+    ChunkColumns,       // Per-column surface metadata of the loaded chunks
+    Count
+};
+
+namespace MemoryTracker {
+    // Adjust the live byte count of a tag (negative to release)
+    void track(MemoryTag tag, int64_t bytes);
+
+    int64_t getBytes(MemoryTag tag);
+    int64_t getPeakBytes(MemoryTag tag);
+    uint64_t getAllocationCount(MemoryTag tag);
+    const char* getTagName(MemoryTag tag);
+
+    // Current and peak resident set size of the process
+    size_t getResidentBytes();
+    size_t getPeakResidentBytes();
+
+    // Snapshot of every tag plus RSS as JSON
+    std::string toJson();
+    bool dumpJson(const std::string& path);
+}
+
+// Keeps a tag in sync with the size of one buffer: call resize() whenever
+// the buffer grows or shrinks, and the bytes are released on destruction.
+class TrackedAllocation {
+public:
+    explicit TrackedAllocation(MemoryTag tag, size_t bytes = 0) : tag(tag), bytes(0) { resize(bytes); }
+    ~TrackedAllocation() { resize(0); }
+
+    TrackedAllocation(const TrackedAllocation&) = delete;
+    TrackedAllocation& operator=(const TrackedAllocation&) = delete;
+
+    void resize(size_t newBytes) {
+        if (newBytes != bytes) {
+            MemoryTracker::track(tag, static_cast<int64_t>(newBytes) - static_cast<int64_t>(bytes));
+            bytes = newBytes;
+        }
+    }
+    size_t size() const { return bytes; }
+
+private:
+    MemoryTag tag;
+    size_t bytes;
+};
@@ -0,0 +1,205 @@
+#include "Profiler.h"
+
+#ifdef VOXEL_ENABLE_PROFILER
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace Profiler {
+    namespace {
+        // Zones kept per thread before the oldest ones are overwritten
+        const uint32_t ZONES_PER_THREAD = 1u << 16;
+        const uint32_t FRAMES_KEPT = 256;
+
+        struct ZoneEvent {
+            const char* name;
+            uint64_t startNs;
+            uint64_t endNs;
+            uint32_t depth;
+        };
+
+        // Single-producer ring: only the owning thread writes events and
+        // publishes them through `head`; readers copy and then re-check `head`
+        // to drop any slot that was overwritten while they were reading.
+        struct ThreadBuffer {
+            std::array<ZoneEvent, ZONES_PER_THREAD> events;
+            std::atomic<uint64_t> head{0};
+            uint32_t depth = 0;
+            uint32_t index = 0;
+            std::string name;
+        };
+
+        struct Registry {
+            std::mutex mutex;  // Guards registration only, never recording
+            std::vector<std::unique_ptr<ThreadBuffer>> threads;
+            std::array<uint64_t, FRAMES_KEPT> frameMarks{};
+            std::atomic<uint64_t> frameCount{0};
+            std::atomic<bool> capturing{true};
+        };
+
+        Registry& registry() {
+            static Registry instance;
+            return instance;
+        }
+
+        ThreadBuffer& threadBuffer() {
+            thread_local ThreadBuffer* buffer = nullptr;
+            if (!buffer) {
+                // Buffers outlive their threads so zones can still be exported
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                reg.threads.push_back(std::make_unique<ThreadBuffer>());
+                buffer = reg.threads.back().get();
+                buffer->index = static_cast<uint32_t>(reg.threads.size() - 1);
+                buffer->name = "Thread " + std::to_string(buffer->index);
+            }
+            return *buffer;
+        }
+
+        template <typename Fn>
+        void forEachEvent(const ThreadBuffer& buffer, Fn&& fn) {
+            uint64_t head = buffer.head.load(std::memory_order_acquire);
+            uint64_t first = head > ZONES_PER_THREAD ? head - ZONES_PER_THREAD : 0;
+            for (uint64_t i = first; i < head; i++) {
+                ZoneEvent event = buffer.events[i % ZONES_PER_THREAD];
+                // Skip the slot if the writer lapped us while copying it
+                uint64_t latest = buffer.head.load(std::memory_order_acquire);
+                if (latest > i + ZONES_PER_THREAD - 1) {
+                    continue;
+                }
+                fn(event);
+            }
+        }
+
+        void writeEscaped(std::ofstream& out, const char* text) {
+            for (const char* c = text; *c; ++c) {
+                if (*c == '"' || *c == '\\') {
+                    out << '\\';
+                }
+                out << *c;
+            }
+        }
+    }
+
+    uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    uint32_t beginZone() {
+        return threadBuffer().depth++;
+    }
+
+    void endZone(const char* name, uint64_t startNs, uint32_t depth) {
+        uint64_t endNs = nowNs();
+        ThreadBuffer& buffer = threadBuffer();
+        buffer.depth = depth;
+        if (!registry().capturing.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        buffer.events[head % ZONES_PER_THREAD] = {name, startNs, endNs, depth};
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void markFrame() {
+        Registry& reg = registry();
+        if (!reg.capturing.load(std::memory_order_relaxed)) {
+            return;
+        }
+        uint64_t count = reg.frameCount.load(std::memory_order_relaxed);
+        reg.frameMarks[count % FRAMES_KEPT] = nowNs();
+        reg.frameCount.store(count + 1, std::memory_order_release);
+    }
+
+    bool getLastFrame(uint64_t& startNs, uint64_t& endNs) {
+        Registry& reg = registry();
+        uint64_t count = reg.frameCount.load(std::memory_order_acquire);
+        if (count < 2) {
+            return false;
+        }
+        startNs = reg.frameMarks[(count - 2) % FRAMES_KEPT];
+        endNs = reg.frameMarks[(count - 1) % FRAMES_KEPT];
+        return true;
+    }
+
+    void setCapturing(bool capturing) {
+        registry().capturing.store(capturing);
+    }
+
+    bool isCapturing() {
+        return registry().capturing.load();
+    }
+
+    void setThreadName(const char* name) {
+        ThreadBuffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        buffer.name = name;
+    }
+
+    std::vector<std::string> getThreadNames() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        std::vector<std::string> names;
+        for (const auto& thread : reg.threads) {
+            names.push_back(thread->name);
+        }
+        return names;
+    }
+
+    std::vector<ZoneRecord> collectZones(uint64_t fromNs, uint64_t toNs) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        std::vector<ZoneRecord> zones;
+        for (const auto& thread : reg.threads) {
+            uint32_t threadIndex = thread->index;
+            forEachEvent(*thread, [&](const ZoneEvent& event) {
+                if (event.endNs >= fromNs && event.startNs <= toNs) {
+                    zones.push_back({event.name, event.startNs, event.endNs, event.depth, threadIndex});
+                }
+            });
+        }
+        return zones;
+    }
+
+    bool exportChromeTrace(const std::string& path) {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            return false;
+        }
+
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        out << std::fixed;
+        out.precision(3);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& thread : reg.threads) {
+            out << (first ? "" : ",") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << thread->index << ",\"args\":{\"name\":\"";
+            writeEscaped(out, thread->name.c_str());
+            out << "\"}}";
+            first = false;
+
+            forEachEvent(*thread, [&](const ZoneEvent& event) {
+                // Chrome trace timestamps are in microseconds
+                out << ",{\"name\":\"";
+                writeEscaped(out, event.name);
+                out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->index
+                    << ",\"ts\":" << static_cast<double>(event.startNs) / 1000.0
+                    << ",\"dur\":" << static_cast<double>(event.endNs - event.startNs) / 1000.0 << "}";
+            });
+        }
+        out << "]}\n";
+        return out.good();
+    }
+}
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped-zone CPU profiler.
+//
+// Zones are recorded with PROFILE_SCOPE("name") / PROFILE_FUNCTION() into a
+// per-thread ring buffer that only its owning thread writes to, so recording
+// never takes a lock. Zone names must be string literals (only the pointer is
+// stored). When VOXEL_ENABLE_PROFILER is not defined every macro expands to
+// nothing and no profiler code is compiled in.
+
+#ifdef VOXEL_ENABLE_PROFILER
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) Profiler::ScopedZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_FRAME_MARK() Profiler::markFrame()
+#define PROFILE_THREAD_NAME(name) Profiler::setThreadName(name)
+
+namespace Profiler {
+    // A completed zone, as returned to the viewer and the trace exporter
+    struct ZoneRecord {
+        const char* name;
+        uint64_t startNs;
+        uint64_t endNs;
+        uint32_t depth;
+        uint32_t threadIndex;
+    };
+
+    // Monotonic clock in nanoseconds
+    uint64_t nowNs();
+
+    // Zone recording (used by ScopedZone)
+    uint32_t beginZone();
+    void endZone(const char* name, uint64_t startNs, uint32_t depth);
+
+    // Frame boundaries, recorded from the main loop
+    void markFrame();
+    bool getLastFrame(uint64_t& startNs, uint64_t& endNs);
+
+    // Pause/resume recording without recompiling
+    void setCapturing(bool capturing);
+    bool isCapturing();
+
+    void setThreadName(const char* name);
+    std::vector<std::string> getThreadNames();
+
+    // Copy every zone overlapping [fromNs, toNs] out of the thread buffers
+    std::vector<ZoneRecord> collectZones(uint64_t fromNs, uint64_t toNs);
+
+    // Write every buffered zone as Chrome trace JSON (chrome://tracing, Perfetto)
+    bool exportChromeTrace(const std::string& path);
+
+    class ScopedZone {
+    public:
+        explicit ScopedZone(const char* name) : name(name), depth(beginZone()), startNs(nowNs()) {}
+        ~ScopedZone() { endZone(name, startNs, depth); }
+
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+    private:
+        const char* name;
+        uint32_t depth;
+        uint64_t startNs;
+    };
+}
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_FRAME_MARK()
+#define PROFILE_THREAD_NAME(name)
+
+#endif
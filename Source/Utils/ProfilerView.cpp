@@ -0,0 +1,129 @@
+#include "ProfilerView.h"
+#include "Profiler.h"
+#include "imgui.h"
+
+#ifdef VOXEL_ENABLE_PROFILER
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace {
+    // Stable colour per zone name so the same zone looks the same every frame
+    ImU32 zoneColor(const char* name) {
+        unsigned int hash = 2166136261u;
+        for (const char* c = name; *c; ++c) {
+            hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+        }
+        return IM_COL32(80 + (hash & 0x7F), 80 + ((hash >> 8) & 0x7F), 80 + ((hash >> 16) & 0x7F), 255);
+    }
+}
+
+void drawProfilerWindow(const std::string& tracePath) {
+    ImGui::SetNextWindowSize(ImVec2(1200, 500), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler");
+
+    uint64_t frameStart, frameEnd;
+    if (!Profiler::getLastFrame(frameStart, frameEnd)) {
+        ImGui::Text("Waiting for frames...");
+        ImGui::End();
+        return;
+    }
+
+    double frameMs = (frameEnd - frameStart) / 1.0e6;
+    ImGui::Text("Last frame: %.2f ms   [P] export Chrome trace to %s", frameMs, tracePath.c_str());
+    ImGui::Separator();
+
+    std::vector<Profiler::ZoneRecord> zones = Profiler::collectZones(frameStart, frameEnd);
+    std::vector<std::string> threadNames = Profiler::getThreadNames();
+
+    // Timeline: one block of depth lanes per thread, time on the x axis
+    const float laneHeight = ImGui::GetTextLineHeight() + 4.0f;
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float width = std::max(ImGui::GetContentRegionAvail().x, 100.0f);
+    double nsToPixels = width / static_cast<double>(frameEnd - frameStart);
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+    float y = origin.y;
+    for (uint32_t thread = 0; thread < threadNames.size(); thread++) {
+        uint32_t maxDepth = 0;
+        bool hasZones = false;
+        for (const auto& zone : zones) {
+            if (zone.threadIndex == thread) {
+                maxDepth = std::max(maxDepth, zone.depth);
+                hasZones = true;
+            }
+        }
+        if (!hasZones) {
+            continue;
+        }
+
+        drawList->AddText(ImVec2(origin.x, y), IM_COL32(200, 200, 200, 255), threadNames[thread].c_str());
+        y += laneHeight;
+
+        for (const auto& zone : zones) {
+            if (zone.threadIndex != thread) {
+                continue;
+            }
+            uint64_t start = std::max(zone.startNs, frameStart);
+            uint64_t end = std::min(zone.endNs, frameEnd);
+            ImVec2 minCorner(origin.x + static_cast<float>((start - frameStart) * nsToPixels),
+                             y + zone.depth * laneHeight);
+            ImVec2 maxCorner(std::max(minCorner.x + 1.0f, origin.x + static_cast<float>((end - frameStart) * nsToPixels)),
+                             minCorner.y + laneHeight - 1.0f);
+            drawList->AddRectFilled(minCorner, maxCorner, zoneColor(zone.name));
+
+            // Label the zone when it is wide enough to hold its name
+            if (maxCorner.x - minCorner.x > ImGui::CalcTextSize(zone.name).x + 4.0f) {
+                drawList->AddText(ImVec2(minCorner.x + 2.0f, minCorner.y + 1.0f), IM_COL32(0, 0, 0, 255), zone.name);
+            }
+            if (ImGui::IsMouseHoveringRect(minCorner, maxCorner)) {
+                ImGui::SetTooltip("%s: %.3f ms", zone.name, (zone.endNs - zone.startNs) / 1.0e6);
+            }
+        }
+        y += (maxDepth + 1) * laneHeight + 4.0f;
+    }
+    ImGui::Dummy(ImVec2(width, y - origin.y));
+    ImGui::Separator();
+
+    // Flat summary: inclusive time and call count per zone name
+    std::map<std::string, std::pair<double, int>> totals;
+    for (const auto& zone : zones) {
+        auto& entry = totals[zone.name];
+        entry.first += (zone.endNs - zone.startNs) / 1.0e6;
+        entry.second++;
+    }
+    std::vector<std::pair<std::string, std::pair<double, int>>> sorted(totals.begin(), totals.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second.first > b.second.first;
+    });
+
+    if (ImGui::BeginTable("ProfilerZones", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Total (ms)");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableHeadersRow();
+        for (const auto& [name, stats] : sorted) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.first);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", stats.second);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+#else
+
+void drawProfilerWindow(const std::string&) {
+    ImGui::Begin("Profiler");
+    ImGui::Text("Profiler disabled (configure with -DVOXEL_ENABLE_PROFILER=ON)");
+    ImGui::End();
+}
+
+#endif
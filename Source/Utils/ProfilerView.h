@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+// ImGui timeline of the last profiled frame plus a per-zone summary.
+// Draws a short notice instead when the profiler is compiled out.
+void drawProfilerWindow(const std::string& tracePath);
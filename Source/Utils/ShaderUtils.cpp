@@ -3,78 +3,348 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <utility>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
 
 namespace ShaderUtils {
-    unsigned int createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath) {
-        unsigned int vertexShader = 0;
-        unsigned int fragmentShader = 0;
-        unsigned int program = 0;
-        int success;
-        char infoLog[512];
-
-        // Load and compile vertex shader
-        std::ifstream vShaderFile(vertexPath);
-        if (!vShaderFile.is_open()) {
-            std::cerr << "ERROR::SHADER::VERTEX::FILE_NOT_SUCCESFULLY_READ: " << vertexPath << "\n";
-            return 0;
+    namespace {
+        // GLSL requires #version to come first, so the prelude goes after it
+        std::string insertPrelude(const std::string& source, const std::string& prelude) {
+            if (prelude.empty()) {
+                return source;
+            }
+            size_t versionPos = source.find("#version");
+            if (versionPos == std::string::npos) {
+                return prelude + "\n" + source;
+            }
+            size_t lineEnd = source.find('\n', versionPos);
+            if (lineEnd == std::string::npos) {
+                return source + "\n" + prelude + "\n";
+            }
+            return source.substr(0, lineEnd + 1) + prelude + "\n" + source.substr(lineEnd + 1);
         }
-        std::stringstream vShaderStream;
-        vShaderStream << vShaderFile.rdbuf();
-        vShaderFile.close();
-        std::string vertexCode = vShaderStream.str();
-        const char* vShaderCode = vertexCode.c_str();
-
-        vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &vShaderCode, NULL);
-        glCompileShader(vertexShader);
-        glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-            std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-            return 0;
+
+        ShaderLoadStats loadStats;
+
+        // Adds the enclosing program load to loadStats
+        struct ScopedLoadTimer {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ~ScopedLoadTimer() {
+                loadStats.programs++;
+                loadStats.totalMs += std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count();
+            }
+        };
+
+        bool readFile(const std::string& path, std::string& contents) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+            std::stringstream stream;
+            stream << file.rdbuf();
+            contents = stream.str();
+            return true;
         }
 
-        // Load and compile fragment shader
-        std::ifstream fShaderFile(fragmentPath);
-        if (!fShaderFile.is_open()) {
-            std::cerr << "ERROR::SHADER::FRAGMENT::FILE_NOT_SUCCESFULLY_READ: " << fragmentPath << "\n";
-            glDeleteShader(vertexShader);
-            return 0;
+        bool isBinaryCacheSupported() {
+            if (!GLAD_GL_VERSION_4_1 || !glGetProgramBinary || !glProgramBinary) {
+                return false;
+            }
+            int formatCount = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+            return formatCount > 0;
         }
-        std::stringstream fShaderStream;
-        fShaderStream << fShaderFile.rdbuf();
-        fShaderFile.close();
-        std::string fragmentCode = fShaderStream.str();
-        const char* fShaderCode = fragmentCode.c_str();
-
-        fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &fShaderCode, NULL);
-        glCompileShader(fragmentShader);
-        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-            std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-            glDeleteShader(vertexShader);
-            return 0;
+
+        unsigned int compileStage(GLenum type, const std::string& code, const char* stageName) {
+            const char* source = code.c_str();
+            unsigned int shader = glCreateShader(type);
+            glShaderSource(shader, 1, &source, NULL);
+            glCompileShader(shader);
+
+            int success;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (!success) {
+                char infoLog[512];
+                glGetShaderInfoLog(shader, 512, NULL, infoLog);
+                std::cerr << "ERROR::SHADER::" << stageName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+                glDeleteShader(shader);
+                return 0;
+            }
+            return shader;
         }
 
-        // Create and link shader program
-        program = glCreateProgram();
-        glAttachShader(program, vertexShader);
-        glAttachShader(program, fragmentShader);
-        glLinkProgram(program);
-        glGetProgramiv(program, GL_LINK_STATUS, &success);
-        if (!success) {
-            glGetProgramInfoLog(program, 512, NULL, infoLog);
-            std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        unsigned int compileAndLink(const std::string& vertexCode, const std::string& fragmentCode) {
+            unsigned int vertexShader = compileStage(GL_VERTEX_SHADER, vertexCode, "VERTEX");
+            if (vertexShader == 0) {
+                return 0;
+            }
+            unsigned int fragmentShader = compileStage(GL_FRAGMENT_SHADER, fragmentCode, "FRAGMENT");
+            if (fragmentShader == 0) {
+                glDeleteShader(vertexShader);
+                return 0;
+            }
+
+            // Create and link shader program
+            unsigned int program = glCreateProgram();
+#ifdef SHADER_CACHE_DIR
+            if (isBinaryCacheSupported()) {
+                glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
+#endif
+            glAttachShader(program, vertexShader);
+            glAttachShader(program, fragmentShader);
+            glLinkProgram(program);
             glDeleteShader(vertexShader);
             glDeleteShader(fragmentShader);
+
+            int success;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success) {
+                char infoLog[512];
+                glGetProgramInfoLog(program, 512, NULL, infoLog);
+                std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+                glDeleteProgram(program);
+                return 0;
+            }
+            return program;
+        }
+
+#ifdef SHADER_CACHE_DIR
+        // Cache file layout: header, then the driver's program binary
+        const uint32_t CACHE_MAGIC = 0x42505856;  // "VXPB"
+        const uint64_t MAX_CACHE_ENTRY_BYTES = 64ull << 20;  // Rejects corrupt lengths
+        struct CacheHeader {
+            uint32_t magic;
+            uint32_t binaryFormat;
+            uint64_t binaryLength;
+        };
+
+        // FNV-1a, chained over several strings
+        uint64_t hashString(const char* text, uint64_t hash = 14695981039346656037ull) {
+            for (const char* c = text ? text : ""; *c; ++c) {
+                hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+            }
+            // Separator, so "ab"+"c" and "a"+"bc" hash differently
+            return (hash ^ 0xffu) * 1099511628211ull;
+        }
+
+        // Binaries are only valid for the exact sources and driver they came from
+        std::string getCachePath(const std::string& vertexCode, const std::string& fragmentCode) {
+            uint64_t hash = hashString(vertexCode.c_str());
+            hash = hashString(fragmentCode.c_str(), hash);
+            hash = hashString(reinterpret_cast<const char*>(glGetString(GL_VENDOR)), hash);
+            hash = hashString(reinterpret_cast<const char*>(glGetString(GL_RENDERER)), hash);
+            hash = hashString(reinterpret_cast<const char*>(glGetString(GL_VERSION)), hash);
+
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+            return (std::filesystem::path(SHADER_CACHE_DIR) / name).string();
+        }
+
+        unsigned int loadCachedProgram(const std::string& path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                return 0;
+            }
+            CacheHeader header;
+            std::vector<char> binary;
+            if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) && header.magic == CACHE_MAGIC &&
+                header.binaryLength <= MAX_CACHE_ENTRY_BYTES) {
+                binary.resize(static_cast<size_t>(header.binaryLength));
+                file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+            }
+            bool complete = !binary.empty() && file.gcount() == static_cast<std::streamsize>(binary.size());
+            file.close();
+
+            if (complete) {
+                unsigned int program = glCreateProgram();
+                glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+                int success = 0;
+                glGetProgramiv(program, GL_LINK_STATUS, &success);
+                if (success) {
+                    return program;
+                }
+                glDeleteProgram(program);
+                glGetError();  // Clear the error left by a rejected format
+            }
+
+            // Truncated, or rejected by the driver (e.g. after a driver
+            // update): drop the entry and recompile from source
+            std::cerr << "Discarding stale shader cache entry " << path << std::endl;
+            std::error_code error;
+            std::filesystem::remove(path, error);
+            return 0;
+        }
+
+        void saveCachedProgram(unsigned int program, const std::string& path) {
+            int length = 0;
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+            if (length <= 0) {
+                return;
+            }
+            std::vector<char> binary(static_cast<size_t>(length));
+            GLenum binaryFormat = 0;
+            glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+            CacheHeader header = {CACHE_MAGIC, binaryFormat, static_cast<uint64_t>(length)};
+
+            // Write to a temporary file and rename it, so an interrupted write
+            // never leaves a truncated entry under the real name
+            std::error_code error;
+            std::filesystem::create_directories(SHADER_CACHE_DIR, error);
+            std::string tempPath = path + ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                if (!file.is_open()) {
+                    std::cerr << "Failed to write shader cache entry " << path << std::endl;
+                    return;
+                }
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(binary.data(), length);
+            }
+            std::filesystem::rename(tempPath, path, error);
+            if (error) {
+                std::filesystem::remove(tempPath, error);
+            }
+        }
+#endif
+    }
+
+    unsigned int createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath) {
+        return createShaderProgram(vertexPath, fragmentPath, "");
+    }
+
+    unsigned int createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                                     const std::string& prelude) {
+        ScopedLoadTimer timer;
+
+        // Load both stages
+        std::string vertexCode;
+        if (!readFile(vertexPath, vertexCode)) {
+            std::cerr << "ERROR::SHADER::VERTEX::FILE_NOT_SUCCESFULLY_READ: " << vertexPath << "\n";
+            return 0;
+        }
+        std::string fragmentCode;
+        if (!readFile(fragmentPath, fragmentCode)) {
+            std::cerr << "ERROR::SHADER::FRAGMENT::FILE_NOT_SUCCESFULLY_READ: " << fragmentPath << "\n";
             return 0;
         }
+        vertexCode = insertPrelude(vertexCode, prelude);
+        fragmentCode = insertPrelude(fragmentCode, prelude);
 
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
+#ifdef SHADER_CACHE_DIR
+        // Reuse the driver's binary from a previous run when the sources and
+        // driver are unchanged
+        bool cacheSupported = isBinaryCacheSupported();
+        std::string cachePath;
+        if (cacheSupported) {
+            cachePath = getCachePath(vertexCode, fragmentCode);
+            unsigned int cached = loadCachedProgram(cachePath);
+            if (cached != 0) {
+                loadStats.cacheHits++;
+                return cached;
+            }
+        }
+#endif
+
+        unsigned int program = compileAndLink(vertexCode, fragmentCode);
 
+#ifdef SHADER_CACHE_DIR
+        if (program != 0 && cacheSupported) {
+            saveCachedProgram(program, cachePath);
+        }
+#endif
         return program;
     }
+
+    const ShaderLoadStats& getShaderLoadStats() {
+        return loadStats;
+    }
+
+    ShaderProgram::~ShaderProgram() {
+        release();
+    }
+
+    ShaderProgram::ShaderProgram(ShaderProgram&& other) noexcept
+        : id(other.id), uniformLocations(std::move(other.uniformLocations)) {
+        other.id = 0;
+    }
+
+    ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other) noexcept {
+        if (this != &other) {
+            release();
+            id = other.id;
+            uniformLocations = std::move(other.uniformLocations);
+            other.id = 0;
+        }
+        return *this;
+    }
+
+    bool ShaderProgram::load(const std::string& vertexPath, const std::string& fragmentPath,
+                             const std::string& prelude) {
+        release();
+        id = createShaderProgram(vertexPath, fragmentPath, prelude);
+        if (id == 0) {
+            return false;
+        }
+        reflectUniforms();
+        return true;
+    }
+
+    void ShaderProgram::release() {
+        if (id != 0) {
+            glDeleteProgram(id);
+            id = 0;
+        }
+        uniformLocations.clear();
+    }
+
+    void ShaderProgram::use() const {
+        glUseProgram(id);
+    }
+
+    int ShaderProgram::getUniformLocation(const std::string& name) const {
+        auto it = uniformLocations.find(name);
+        return it != uniformLocations.end() ? it->second : -1;
+    }
+
+    void ShaderProgram::bindUniformBlock(const char* blockName, unsigned int binding) const {
+        unsigned int blockIndex = glGetUniformBlockIndex(id, blockName);
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(id, blockIndex, binding);
+        }
+    }
+
+    void ShaderProgram::reflectUniforms() {
+        int uniformCount = 0;
+        int maxNameLength = 0;
+        glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &uniformCount);
+        glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::string name(static_cast<size_t>(maxNameLength), '\0');
+        for (int i = 0; i < uniformCount; i++) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(id, static_cast<GLuint>(i), maxNameLength, &length, &size, &type, &name[0]);
+            std::string uniformName = name.substr(0, static_cast<size_t>(length));
+
+            // Uniform block members have no location
+            int location = glGetUniformLocation(id, uniformName.c_str());
+            if (location < 0) {
+                continue;
+            }
+            uniformLocations[uniformName] = location;
+
+            // Arrays are reported as "name[0]"; also register the plain name
+            size_t bracket = uniformName.find('[');
+            if (bracket != std::string::npos) {
+                uniformLocations[uniformName.substr(0, bracket)] = location;
+            }
+        }
+    }
 }
\ No newline at end of file
@@ -1,7 +1,60 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 
 namespace ShaderUtils {
     unsigned int createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+
+    // Same, with `prelude` (generated declarations, #defines) inserted right
+    // after the #version line of both stages
+    unsigned int createShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                                     const std::string& prelude);
+
+    // Program loads since startup, to report how long shader setup took.
+    // When built with SHADER_CACHE_DIR, linked binaries are cached there
+    // (keyed by the sources and driver) and reused on the next launch.
+    struct ShaderLoadStats {
+        int programs = 0;
+        int cacheHits = 0;
+        double totalMs = 0.0;
+    };
+    const ShaderLoadStats& getShaderLoadStats();
+
+    // A linked program that looks up its active uniforms once at link time, so
+    // per-frame code never calls glGetUniformLocation. Owns the GL program.
+    class ShaderProgram {
+    public:
+        ShaderProgram() = default;
+        ~ShaderProgram();
+
+        ShaderProgram(ShaderProgram&& other) noexcept;
+        ShaderProgram& operator=(ShaderProgram&& other) noexcept;
+        ShaderProgram(const ShaderProgram&) = delete;
+        ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+        // Compile, link and reflect; false (and an invalid program) on failure
+        bool load(const std::string& vertexPath, const std::string& fragmentPath,
+                  const std::string& prelude = "");
+
+        // Delete the GL program, e.g. before the context is destroyed
+        void release();
+
+        bool isValid() const { return id != 0; }
+        unsigned int getId() const { return id; }
+        void use() const;
+
+        // Cached location of an active uniform, -1 if the program does not use
+        // it. Arrays are found both as "name" and "name[0]".
+        int getUniformLocation(const std::string& name) const;
+
+        // Attach a uniform block to a binding point (no-op if the block is unused)
+        void bindUniformBlock(const char* blockName, unsigned int binding) const;
+
+    private:
+        void reflectUniforms();
+
+        unsigned int id = 0;
+        std::unordered_map<std::string, int> uniformLocations;
+    };
 }
\ No newline at end of file
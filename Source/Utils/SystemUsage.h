@@ -0,0 +1,62 @@
+#pragma once
+
+#include <sys/types.h>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+#ifdef VOXEL_HAS_NVML
+#include <nvml.h>
+#endif
+
+// Process GPU/RAM/CPU usage for the debug overlay. GPU memory is read
+// through NVML when the engine is built with it (VOXEL_HAS_NVML) and
+// reported as 0 otherwise.
+class SystemUsage {
+public:
+    SystemUsage();
+    ~SystemUsage();
+
+    // GPU memory usage in MB
+    unsigned int getGpuMemoryUsageMB();
+
+    // Current RAM usage (resident set) in MB
+    long getRamUsageMB();
+
+    // Peak RAM usage in MB; never decreases
+    long getPeakRamUsageMB();
+
+    // CPU usage percentage (approximate, over a short delay)
+    double getCpuUsagePercent();
+
+private:
+#ifdef VOXEL_HAS_NVML
+    nvmlDevice_t device;
+#endif
+    bool nvmlAvailable = false;
+    pid_t pid;
+
+    unsigned long long getTotalCpuTime(std::ifstream& file);
+    unsigned long long getProcessCpuTime(std::ifstream& file);
+};
+
+class SystemUsageAsync {
+public:
+    SystemUsageAsync();
+    ~SystemUsageAsync();
+
+    double getCpuUsagePercent() const {
+        return lastCpuUsage.load();
+    }
+
+private:
+    std::atomic<double> lastCpuUsage{0.0};
+    std::atomic<bool> running{false};
+    std::thread usageThread;
+    unsigned int numCores;
+    long clkTck;
+
+    unsigned long long getTotalCpuTime();
+    unsigned long long getProcessCpuTime(pid_t pid);
+    void updateCpuUsageLoop();
+};
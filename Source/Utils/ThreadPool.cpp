@@ -0,0 +1,148 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <string>
+#include "Profiler.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+    for (unsigned int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+    for (auto& batch : batches) {
+        batch = std::make_unique<Batch>();
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (; taskCount > 0; taskCount--) {
+            tasks[firstTask] = nullptr;
+            firstTask = (firstTask + 1) % tasks.size();
+        }
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (taskCount == tasks.size()) {
+            // Full: unroll the ring into a larger one
+            std::vector<std::function<void()>> grown(std::max<size_t>(16, tasks.size() * 2));
+            for (size_t i = 0; i < taskCount; i++) {
+                grown[i] = std::move(tasks[(firstTask + i) % tasks.size()]);
+            }
+            tasks.swap(grown);
+            firstTask = 0;
+        }
+        tasks[(firstTask + taskCount) % tasks.size()] = std::move(task);
+        taskCount++;
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::Batch::work() {
+    size_t done = 0;
+    for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+        (*body)(i);
+        done++;
+    }
+    if (done > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        completed += done;
+        if (completed == count) {
+            finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    // The call returns once every claimed index is done. Helpers that only
+    // start after the last index was claimed find nothing to do and never
+    // touch body, but they still hold the batch, so it is only reused once
+    // they have all run.
+    Batch* batch = nullptr;
+    for (const auto& spare : batches) {
+        if (spare->helpers.load(std::memory_order_acquire) == 0) {
+            batch = spare.get();
+            break;
+        }
+    }
+    if (!batch) {
+        // Every batch waits for helpers queued behind other tasks, so the
+        // workers would not get to this one soon either
+        for (size_t i = 0; i < count; i++) {
+            body(i);
+        }
+        return;
+    }
+    batch->count = count;
+    batch->body = &body;
+    batch->completed = 0;
+    batch->next.store(0);
+
+    size_t helpers = std::min(workers.size(), count - 1);
+    batch->helpers.store(helpers);
+    for (size_t i = 0; i < helpers; i++) {
+        submit([batch]() {
+            batch->work();
+            batch->helpers.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    batch->work();
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [batch]() { return batch->completed == batch->count; });
+}
+
+void ThreadPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return taskCount == 0 && runningTasks == 0; });
+}
+
+void ThreadPool::workerLoop(unsigned int index) {
+#ifdef VOXEL_ENABLE_PROFILER
+    std::string name = "Worker " + std::to_string(index);
+    PROFILE_THREAD_NAME(name.c_str());
+#else
+    (void)index;
+#endif
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this]() { return stopping || taskCount > 0; });
+            if (stopping) {
+                return;
+            }
+            task = std::move(tasks[firstTask]);
+            tasks[firstTask] = nullptr;
+            firstTask = (firstTask + 1) % tasks.size();
+            taskCount--;
+            runningTasks++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            runningTasks--;
+            if (taskCount == 0 && runningTasks == 0) {
+                idle.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running queued tasks in submission order.
+// Tasks must not touch state owned by the main thread; they hand results
+// back through their own synchronised channel.
+class ThreadPool {
+public:
+    // 0 picks one worker per hardware thread, leaving one for the main thread
+    explicit ThreadPool(unsigned int threadCount = 0);
+    // Drops tasks that have not started and waits for the running ones
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Run body(i) for every i in [0, count) on the calling thread and the
+    // workers together, and return once all are done. Workers busy with
+    // earlier tasks join in when they get to it; the calling thread does
+    // not wait for them, and runs everything alone while the helpers of
+    // several earlier calls are still queued. Not for use from inside a task.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // Block until the queue is empty and no task is running
+    void waitIdle();
+
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    // Indices of one parallelFor call, claimed one at a time by whoever is
+    // free. A batch is reused by a later call once no helper holds it.
+    struct Batch {
+        std::atomic<size_t> next{0};
+        size_t count = 0;
+        const std::function<void(size_t)>* body = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t completed = 0;
+        std::atomic<size_t> helpers{0};  // Helper tasks queued or running
+
+        void work();
+    };
+
+    std::vector<std::thread> workers;
+    // Queued tasks: a ring of taskCount slots from firstTask. It only grows,
+    // so queueing allocates nothing once it has reached its high-water mark.
+    std::vector<std::function<void()>> tasks;
+    size_t firstTask = 0;
+    size_t taskCount = 0;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable idle;
+    unsigned int runningTasks = 0;
+    bool stopping = false;
+    // Created up front, so parallelFor never allocates. Only touched by the
+    // thread calling parallelFor.
+    static const size_t BATCH_COUNT = 8;
+    std::array<std::unique_ptr<Batch>, BATCH_COUNT> batches;
+
+    void workerLoop(unsigned int index);
+};
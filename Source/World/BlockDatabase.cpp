@@ -1,118 +1,109 @@
 #include "BlockDatabase.h"
-
-BlockDatabase& BlockDatabase::getInstance() {
-    static BlockDatabase instance;
-    return instance;
-}
+#include <algorithm>
 
 BlockDatabase::BlockDatabase() {
+    // Unregistered ids behave like air
+    transparent.fill(true);
     initializeBlockData();
 }
 
 void BlockDatabase::initializeBlockData() {
-    // Register all block types with their textures
+    // Register all block types with their atlas tiles (column, row)
     
-    // AIR block (transparent)
-    registerBlock(BlockType::AIR, "Air",
-                 BlockTexture(glm::vec2(0, 0), true),  // All faces transparent
-                 BlockTexture(glm::vec2(0, 0), true),
-                 BlockTexture(glm::vec2(0, 0), true),
-                 true);
+    BlockProperties air;
+    air.solid = false;
+    air.opaque = false;
+    air.transparent = true;
+    registerBlock(BlockType::AIR, "Air", glm::vec2(0, 0), glm::vec2(0, 0), glm::vec2(0, 0), air);
 
     // GRASS block
     registerBlock(BlockType::GRASS, "Grass",
-                 BlockTexture(glm::vec2(0, 0)),  // Top (green grass)
-                 BlockTexture(glm::vec2(2, 0)),  // Bottom (dirt)
-                 BlockTexture(glm::vec2(3, 0))); // Sides (grass side)
+                 glm::vec2(0, 0),  // Top (green grass)
+                 glm::vec2(2, 0),  // Bottom (dirt)
+                 glm::vec2(3, 0)); // Sides (grass side)
 
     // DIRT block
-    registerBlock(BlockType::DIRT, "Dirt",
-                 BlockTexture(glm::vec2(2, 0)),  // All faces dirt
-                 BlockTexture(glm::vec2(2, 0)),
-                 BlockTexture(glm::vec2(2, 0)));
+    registerBlock(BlockType::DIRT, "Dirt", glm::vec2(2, 0), glm::vec2(2, 0), glm::vec2(2, 0));
 
     // STONE block
-    registerBlock(BlockType::STONE, "Stone",
-                 BlockTexture(glm::vec2(1, 0)),  // All faces stone
-                 BlockTexture(glm::vec2(1, 0)),
-                 BlockTexture(glm::vec2(1, 0)));
+    registerBlock(BlockType::STONE, "Stone", glm::vec2(1, 0), glm::vec2(1, 0), glm::vec2(1, 0));
 
     // WOOD_LOG block
-    registerBlock(BlockType::WOOD_LOG, "Wood Log",
-                 BlockTexture(glm::vec2(5, 0)),  // Top (wood end)
-                 BlockTexture(glm::vec2(5, 0)),  // Bottom (wood end)
-                 BlockTexture(glm::vec2(4, 0))); // Sides (wood bark)
+    registerBlock(BlockType::WOOD_LOG, "Wood Log", glm::vec2(4, 1), glm::vec2(4, 1), glm::vec2(4, 1));
 
-    // LEAVES block (slightly transparent)
+    // LEAVES block: lets light through, but still culls neighbouring faces.
+    // The gaps in its texture are cut out.
+    BlockProperties leaves;
+    leaves.transparent = true;
+    leaves.renderLayer = RenderLayer::CUTOUT;
     registerBlock(BlockType::LEAVES, "Leaves",
-                 BlockTexture(glm::vec2(6, 0), true),  // All faces leaves
-                 BlockTexture(glm::vec2(6, 0), true),
-                 BlockTexture(glm::vec2(6, 0), true),
-                 true);
+                 glm::vec2(4, 3),  // Top
+                 glm::vec2(4, 3),  // Bottom
+                 glm::vec2(5, 3),  // Sides
+                 leaves);
+
+    // LAVA block (full-strength block light emitter)
+    BlockProperties lava;
+    lava.lightEmission = 15;
+    registerBlock(BlockType::LAVA, "Lava", glm::vec2(7, 0), glm::vec2(7, 0), glm::vec2(7, 0), lava);
+
+    // WATER block: not solid, and the faces behind it stay visible
+    BlockProperties water;
+    water.solid = false;
+    water.opaque = false;
+    water.transparent = true;
+    water.renderLayer = RenderLayer::TRANSLUCENT;
+    registerBlock(BlockType::WATER, "Water", glm::vec2(0, 9), glm::vec2(0, 9), glm::vec2(0, 9), water);
 
     // SAND block
-    registerBlock(BlockType::SAND, "Sand",
-                 BlockTexture(glm::vec2(7, 0)),  // All faces sand
-                 BlockTexture(glm::vec2(7, 0)),
-                 BlockTexture(glm::vec2(7, 0)));
-
-    // WATER block (transparent)
-    registerBlock(BlockType::WATER, "Water",
-                 BlockTexture(glm::vec2(8, 0), true),  // All faces water
-                 BlockTexture(glm::vec2(8, 0), true),
-                 BlockTexture(glm::vec2(8, 0), true),
-                 true);
+    registerBlock(BlockType::SAND, "Sand", glm::vec2(2, 1), glm::vec2(2, 1), glm::vec2(2, 1));
 }
 
 void BlockDatabase::registerBlock(BlockType type, const std::string& name,
-                                const BlockTexture& top, const BlockTexture& bottom,
-                                const BlockTexture& sides, bool isTransparent) {
-    blockNames[type] = name;
-    transparencyData[type] = isTransparent;
-    
-    blockData[type][BlockFace::TOP] = top;
-    blockData[type][BlockFace::BOTTOM] = bottom;
-    blockData[type][BlockFace::FRONT] = sides;
-    blockData[type][BlockFace::BACK] = sides;
-    blockData[type][BlockFace::LEFT] = sides;
-    blockData[type][BlockFace::RIGHT] = sides;
+                                const glm::vec2& top, const glm::vec2& bottom,
+                                const glm::vec2& sides, const BlockProperties& properties) {
+    registerBlock(type, name, top, bottom, sides, sides, sides, sides, properties);
 }
 
 void BlockDatabase::registerBlock(BlockType type, const std::string& name,
-                                const BlockTexture& top, const BlockTexture& bottom,
-                                const BlockTexture& front, const BlockTexture& back,
-                                const BlockTexture& left, const BlockTexture& right,
-                                bool isTransparent) {
-    blockNames[type] = name;
-    transparencyData[type] = isTransparent;
+                                const glm::vec2& top, const glm::vec2& bottom,
+                                const glm::vec2& front, const glm::vec2& back,
+                                const glm::vec2& left, const glm::vec2& right,
+                                const BlockProperties& properties) {
+    unsigned int id = static_cast<unsigned int>(type);
+    
+    blockNames[id] = name;
+    solid[id] = properties.solid;
+    opaque[id] = properties.opaque;
+    transparent[id] = properties.transparent;
+    emission[id] = properties.lightEmission;
+    renderLayers[id] = properties.renderLayer;
     
-    blockData[type][BlockFace::TOP] = top;
-    blockData[type][BlockFace::BOTTOM] = bottom;
-    blockData[type][BlockFace::FRONT] = front;
-    blockData[type][BlockFace::BACK] = back;
-    blockData[type][BlockFace::LEFT] = left;
-    blockData[type][BlockFace::RIGHT] = right;
+    glm::vec2* tiles = &faceTiles[id * FACE_COUNT];
+    tiles[static_cast<unsigned int>(BlockFace::TOP)] = top;
+    tiles[static_cast<unsigned int>(BlockFace::BOTTOM)] = bottom;
+    tiles[static_cast<unsigned int>(BlockFace::FRONT)] = front;
+    tiles[static_cast<unsigned int>(BlockFace::BACK)] = back;
+    tiles[static_cast<unsigned int>(BlockFace::LEFT)] = left;
+    tiles[static_cast<unsigned int>(BlockFace::RIGHT)] = right;
+    
+    blockTypeCount = std::max(blockTypeCount, id + 1);
 }
 
 BlockTexture BlockDatabase::getBlockTexture(BlockType type, BlockFace face) const {
-    if (blockData.find(type) == blockData.end()) {
-        return BlockTexture(); // Return default texture if block type not found
-    }
-    
-    const auto& faceMap = blockData.at(type);
-    if (faceMap.find(face) == faceMap.end()) {
-        return BlockTexture(); // Return default texture if face not found
-    }
-    
-    return faceMap.at(face);
+    unsigned int id = static_cast<unsigned int>(type);
+    return BlockTexture(getFaceTile(id, face), isTransparent(id));
 }
 
 bool BlockDatabase::isBlockTransparent(BlockType type) const {
-    auto it = transparencyData.find(type);
-    return it != transparencyData.end() && it->second;
+    return isTransparent(static_cast<unsigned int>(type));
+}
+
+unsigned char BlockDatabase::getLightEmission(BlockType type) const {
+    return getEmission(static_cast<unsigned int>(type));
 }
 
 std::string BlockDatabase::getBlockName(BlockType type) const {
-    auto it = blockNames.find(type);
-    return it != blockNames.end() ? it->second : "Unknown";
-}
\ No newline at end of file
+    unsigned int id = static_cast<unsigned int>(type);
+    return id < MAX_BLOCK_TYPES && !blockNames[id].empty() ? blockNames[id] : "Unknown";
+}
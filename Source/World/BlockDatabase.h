@@ -2,16 +2,17 @@
 #define BLOCK_DATABASE_H
 
 #include <glm/glm.hpp>
-#include <unordered_map>
+#include <array>
 #include <string>
 
+// Face order used by the tile table (and by the voxel shader)
 enum class BlockFace {
     TOP,
     BOTTOM,
-    FRONT,
-    BACK,
-    LEFT,
-    RIGHT
+    FRONT,   // +Z
+    BACK,    // -Z
+    LEFT,    // -X
+    RIGHT    // +X
 };
 
 enum class BlockType : unsigned int {
@@ -21,10 +22,19 @@ enum class BlockType : unsigned int {
     STONE = 3,
     WOOD_LOG = 4,
     LEAVES = 5,
-    SAND = 6,
-    WATER = 7
+    LAVA = 6,
+    WATER = 7,
+    SAND = 8
 };
 
+// Pass of the main render that draws a block's faces
+enum class RenderLayer : unsigned int {
+    OPAQUE,       // Depth-tested and written, drawn front to back
+    CUTOUT,       // Like OPAQUE, but texels with low alpha are discarded (leaves)
+    TRANSLUCENT   // Blended over the scene without depth writes, drawn back to front (water)
+};
+constexpr unsigned int RENDER_LAYER_COUNT = 3;
+
 struct BlockTexture {
     glm::vec2 textureCoords;  // UV coordinates in the texture atlas
     bool isTransparent;       // Whether this texture has transparency
@@ -33,15 +43,52 @@ struct BlockTexture {
         : textureCoords(coords), isTransparent(transparent) {}
 };
 
+// Per-block flags given at registration
+struct BlockProperties {
+    bool solid = true;               // Collides with the player
+    bool opaque = true;              // Hides the faces of neighbouring blocks
+    bool transparent = false;        // Lets block light through
+    unsigned char lightEmission = 0; // 0 = none, 15 = brightest
+    RenderLayer renderLayer = RenderLayer::OPAQUE;
+};
+
+// Single registry of every block type. Registrations are compiled into flat
+// arrays indexed by block id, so the hot-path property checks (collision,
+// face culling, light flood fill) are one load each. Ids that were never
+// registered behave like air.
 class BlockDatabase {
 public:
-    static BlockDatabase& getInstance();
+    static constexpr unsigned int MAX_BLOCK_TYPES = 256;
+    static constexpr unsigned int FACE_COUNT = 6;
+
+    static BlockDatabase& getInstance() {
+        static BlockDatabase instance;
+        return instance;
+    }
+    
+    // Hot-path property lookups by raw block id
+    bool isSolid(unsigned int id) const { return id < MAX_BLOCK_TYPES && solid[id]; }
+    bool isOpaque(unsigned int id) const { return id < MAX_BLOCK_TYPES && opaque[id]; }
+    bool isTransparent(unsigned int id) const { return id >= MAX_BLOCK_TYPES || transparent[id]; }
+    unsigned char getEmission(unsigned int id) const { return id < MAX_BLOCK_TYPES ? emission[id] : 0; }
+    RenderLayer getRenderLayer(unsigned int id) const { return id < MAX_BLOCK_TYPES ? renderLayers[id] : RenderLayer::OPAQUE; }
+    
+    // Atlas tile (column, row) of one face of a block
+    glm::vec2 getFaceTile(unsigned int id, BlockFace face) const {
+        return id < MAX_BLOCK_TYPES ? faceTiles[id * FACE_COUNT + static_cast<unsigned int>(face)] : glm::vec2(0.0f);
+    }
+    
+    // One past the highest registered id; the size of the renderer's tile table
+    unsigned int getBlockTypeCount() const { return blockTypeCount; }
     
     // Get texture coordinates for a specific block face
     BlockTexture getBlockTexture(BlockType type, BlockFace face) const;
     
     // Check if a block type is transparent
     bool isBlockTransparent(BlockType type) const;
+
+    // Block light emitted by a block type (0 = none, 15 = brightest)
+    unsigned char getLightEmission(BlockType type) const;
     
     // Get the name of a block type (for debugging/UI)
     std::string getBlockName(BlockType type) const;
@@ -49,20 +96,25 @@ public:
 private:
     BlockDatabase();  // Private constructor for singleton
     
-    // Texture data for each block type and face
-    std::unordered_map<BlockType, std::unordered_map<BlockFace, BlockTexture>> blockData;
-    std::unordered_map<BlockType, std::string> blockNames;
-    std::unordered_map<BlockType, bool> transparencyData;
+    // Property tables indexed by block id
+    std::array<bool, MAX_BLOCK_TYPES> solid{};
+    std::array<bool, MAX_BLOCK_TYPES> opaque{};
+    std::array<bool, MAX_BLOCK_TYPES> transparent{};
+    std::array<unsigned char, MAX_BLOCK_TYPES> emission{};
+    std::array<RenderLayer, MAX_BLOCK_TYPES> renderLayers{};
+    std::array<glm::vec2, MAX_BLOCK_TYPES * FACE_COUNT> faceTiles{};
+    std::array<std::string, MAX_BLOCK_TYPES> blockNames;
+    unsigned int blockTypeCount = 0;
 
     void initializeBlockData();
-    void registerBlock(BlockType type, const std::string& name, 
-                      const BlockTexture& top, const BlockTexture& bottom,
-                      const BlockTexture& sides, bool isTransparent = false);
     void registerBlock(BlockType type, const std::string& name,
-                      const BlockTexture& top, const BlockTexture& bottom,
-                      const BlockTexture& front, const BlockTexture& back,
-                      const BlockTexture& left, const BlockTexture& right,
-                      bool isTransparent = false);
+                      const glm::vec2& top, const glm::vec2& bottom,
+                      const glm::vec2& sides, const BlockProperties& properties = BlockProperties());
+    void registerBlock(BlockType type, const std::string& name,
+                      const glm::vec2& top, const glm::vec2& bottom,
+                      const glm::vec2& front, const glm::vec2& back,
+                      const glm::vec2& left, const glm::vec2& right,
+                      const BlockProperties& properties = BlockProperties());
 };
 
-#endif // BLOCK_DATABASE_H
\ No newline at end of file
+#endif // BLOCK_DATABASE_H
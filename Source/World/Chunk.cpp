@@ -1,16 +1,366 @@
 #include "Chunk.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include "BlockDatabase.h"
+#include "../Utils/Profiler.h"
 
-Chunk::Chunk(int chunkX, int chunkZ, float voxelScale)
-    : chunkX(chunkX), chunkZ(chunkZ), voxelScale(voxelScale), isDirty(true) {
+namespace {
+    const BlockDatabase& blockDatabase = BlockDatabase::getInstance();
+    
+    // Neighbour offset of each BlockFace, in BlockFace order
+    const int FACE_OFFSETS[BlockDatabase::FACE_COUNT][3] = {
+        {0, 1, 0},   // TOP
+        {0, -1, 0},  // BOTTOM
+        {0, 0, 1},   // FRONT (+Z)
+        {0, 0, -1},  // BACK (-Z)
+        {-1, 0, 0},  // LEFT (-X)
+        {1, 0, 0}    // RIGHT (+X)
+    };
+    
+    static_assert(Chunk::CHUNK_SIZE_X <= (1 << PackedFaceLayout::X_BITS) &&
+                  Chunk::CHUNK_SIZE_Y <= (1 << PackedFaceLayout::Y_BITS) &&
+                  Chunk::CHUNK_SIZE_Z <= (1 << PackedFaceLayout::Z_BITS),
+                  "Local voxel positions must fit in a PackedFace");
+    static_assert(BlockDatabase::MAX_BLOCK_TYPES <= (1 << PackedFaceLayout::BLOCK_BITS),
+                  "Block ids must fit in a PackedFace");
+    static_assert(BlockDatabase::FACE_COUNT <= (1 << PackedFaceLayout::FACE_BITS),
+                  "Face indices must fit in a PackedFace");
+    static_assert(Chunk::CHUNK_SIZE_X % (1 << (Chunk::LOD_LEVELS - 1)) == 0 &&
+                  Chunk::CHUNK_SIZE_Y % (1 << (Chunk::LOD_LEVELS - 1)) == 0 &&
+                  Chunk::CHUNK_SIZE_Z % (1 << (Chunk::LOD_LEVELS - 1)) == 0,
+                  "Chunk dimensions must be whole numbers of LOD cells");
+    static_assert(Chunk::CHUNK_SIZE_Y <= 64 &&
+                  Chunk::CHUNK_SIZE_X % Chunk::OCCLUDER_CELL_SIZE == 0 &&
+                  Chunk::CHUNK_SIZE_Z % Chunk::OCCLUDER_CELL_SIZE == 0,
+                  "Occluder cells need whole column groups and one bit per voxel of height");
+    
+    using ColumnMasks = std::array<uint64_t, Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Z>;
+    
+    // Flood fill every region of non-opaque cells in a chunk of
+    // sizeX x sizeY x sizeZ cells; all the sides a region touches can see
+    // each other through it. `opaque` holds one flag per cell, x fastest.
+    Chunk::Connectivity computeConnectivity(int sizeX, int sizeY, int sizeZ, const unsigned char* opaque) {
+        const int volume = sizeX * sizeY * sizeZ;
+        const int MAX_CELLS = Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Y * Chunk::CHUNK_SIZE_Z;
+        
+        // Chunks of only air or only solid cells are by far the most common
+        int opaqueCells = 0;
+        for (int cell = 0; cell < volume; cell++) {
+            opaqueCells += opaque[cell];
+        }
+        if (opaqueCells == 0) {
+            return Chunk::ALL_SIDES_CONNECTED;
+        }
+        if (opaqueCells == volume) {
+            return 0;
+        }
+        
+        // Every cell is pushed at most once, so the stack never outgrows the
+        // chunk. Entries carry their coordinates (x | y << 8 | z << 16).
+        std::array<unsigned char, MAX_CELLS> visited{};
+        std::array<uint32_t, MAX_CELLS> stack;
+        const int sliceSize = sizeX * sizeY;
+        Chunk::Connectivity connectivity = 0;
+        for (int start = 0; start < volume; start++) {
+            if (visited[start] || opaque[start]) {
+                continue;
+            }
+            
+            unsigned int sidesTouched = 0;
+            int stackSize = 0;
+            visited[start] = 1;
+            stack[stackSize++] = (start % sizeX) | (((start / sizeX) % sizeY) << 8) | ((start / sliceSize) << 16);
+            while (stackSize > 0) {
+                uint32_t entry = stack[--stackSize];
+                int x = entry & 0xff;
+                int y = (entry >> 8) & 0xff;
+                int z = entry >> 16;
+                
+                for (unsigned int face = 0; face < BlockDatabase::FACE_COUNT; face++) {
+                    const int* offset = FACE_OFFSETS[face];
+                    int nx = x + offset[0];
+                    int ny = y + offset[1];
+                    int nz = z + offset[2];
+                    if (nx < 0 || nx >= sizeX || ny < 0 || ny >= sizeY || nz < 0 || nz >= sizeZ) {
+                        sidesTouched |= 1u << face;
+                        continue;
+                    }
+                    int neighbor = nx + ny * sizeX + nz * sliceSize;
+                    if (!visited[neighbor] && !opaque[neighbor]) {
+                        visited[neighbor] = 1;
+                        stack[stackSize++] = nx | (ny << 8) | (nz << 16);
+                    }
+                }
+            }
+            
+            for (unsigned int sideA = 0; sideA < BlockDatabase::FACE_COUNT; sideA++) {
+                if (sidesTouched & (1u << sideA)) {
+                    for (unsigned int sideB = 0; sideB < BlockDatabase::FACE_COUNT; sideB++) {
+                        if (sidesTouched & (1u << sideB)) {
+                            connectivity |= Chunk::Connectivity(1) << (sideA * 6 + sideB);
+                        }
+                    }
+                }
+            }
+        }
+        
+        return connectivity;
+    }
+    
+    // Occluders of a full-resolution mesh. columnOpaque has bit y set for
+    // every opaque voxel of column x + z * CHUNK_SIZE_X. Each group of
+    // OCCLUDER_CELL_SIZE x OCCLUDER_CELL_SIZE columns gives the longest
+    // height range opaque in all of them, and neighbouring groups along X
+    // with the same range are merged into one box.
+    void findOccluderBoxes(const ColumnMasks& columnOpaque, std::vector<Chunk::OccluderBox>& boxes) {
+        const int cell = Chunk::OCCLUDER_CELL_SIZE;
+        boxes.clear();
+        for (int z0 = 0; z0 < Chunk::CHUNK_SIZE_Z; z0 += cell) {
+            Chunk::OccluderBox current = {};
+            bool open = false;
+            for (int x0 = 0; x0 < Chunk::CHUNK_SIZE_X; x0 += cell) {
+                uint64_t solid = ~uint64_t(0);
+                for (int z = z0; z < z0 + cell; z++) {
+                    for (int x = x0; x < x0 + cell; x++) {
+                        solid &= columnOpaque[x + z * Chunk::CHUNK_SIZE_X];
+                    }
+                }
+                
+                int bestStart = 0;
+                int bestLength = 0;
+                int runStart = 0;
+                for (int y = 0; y <= Chunk::CHUNK_SIZE_Y; y++) {
+                    bool filled = y < Chunk::CHUNK_SIZE_Y && ((solid >> y) & 1);
+                    if (!filled) {
+                        if (y - runStart > bestLength) {
+                            bestStart = runStart;
+                            bestLength = y - runStart;
+                        }
+                        runStart = y + 1;
+                    }
+                }
+                
+                if (open && bestLength > 0 && current.minY == bestStart && current.maxY == bestStart + bestLength) {
+                    current.maxX = static_cast<uint8_t>(x0 + cell);
+                    continue;
+                }
+                if (open) {
+                    boxes.push_back(current);
+                    open = false;
+                }
+                if (bestLength > 0) {
+                    current = {static_cast<uint8_t>(x0), static_cast<uint8_t>(bestStart), static_cast<uint8_t>(z0),
+                               static_cast<uint8_t>(x0 + cell), static_cast<uint8_t>(bestStart + bestLength),
+                               static_cast<uint8_t>(z0 + cell)};
+                    open = true;
+                }
+            }
+            if (open) {
+                boxes.push_back(current);
+            }
+        }
+    }
+    
+    // Whether a face of blockId is drawn. Opaque neighbours hide it, and so
+    // do neighbours of the same block, so a body of water has no inner
+    // faces. Past the chunk's edge with no known neighbour the face is
+    // drawn, except on the chunk's sides for translucent blocks: water runs
+    // on across chunk borders, and those faces would show through it as walls.
+    bool isFaceShown(unsigned int blockId, bool neighborKnown, unsigned int neighborId, unsigned int face) {
+        if (!neighborKnown) {
+            return face <= static_cast<unsigned int>(BlockFace::BOTTOM) ||
+                   blockDatabase.getRenderLayer(blockId) != RenderLayer::TRANSLUCENT;
+        }
+        return !blockDatabase.isOpaque(neighborId) && neighborId != blockId;
+    }
+    
+    // One cell of a reduced mesh, from the voxels it covers
+    struct LodCell {
+        bool filled = false;      // At least half of the voxels are
+        unsigned int top = 0;     // Highest non-air voxel
+        unsigned int bottom = 0;  // Lowest non-air voxel
+        unsigned char light = 0;  // Brightest voxel
+    };
+    
+    // Per-cell scratch of a reduced mesh build, kept by each thread
+    struct LodCellBuffers {
+        std::vector<LodCell> reduced;
+        std::vector<unsigned int> blocks;
+        std::vector<unsigned char> opaque;
+    };
+    
+    // Face buffers of cleared meshes, for the next meshes built on any
+    // thread. A buffer's capacity is MIN_CAPACITY times a power of two, and
+    // a mesh takes a spare one of the smallest size that fits, so buffers
+    // circulate between chunks and streaming allocates nothing once each
+    // size has reached the most meshes that need it at once.
+    class FaceBufferPool {
+    public:
+        static FaceBufferPool& getInstance() {
+            static FaceBufferPool pool;
+            return pool;
+        }
+        
+        // Take the buffer of faces, which is left without one
+        void release(std::vector<PackedFace>& faces) {
+            size_t sizeClass = getSizeClass(faces.capacity());
+            if (faces.capacity() < MIN_CAPACITY || sizeClass >= CLASS_COUNT) {
+                faces = std::vector<PackedFace>();
+                return;
+            }
+            faces.clear();
+            std::lock_guard<std::mutex> lock(mutex);
+            spareBytes += faces.capacity() * sizeof(PackedFace);
+            spare[sizeClass].push_back(std::move(faces));
+            memory.resize(spareBytes);
+        }
+        
+        // Give the empty faces a buffer for at least count faces
+        void acquire(std::vector<PackedFace>& faces, size_t count) {
+            if (faces.capacity() >= count) {
+                return;
+            }
+            release(faces);
+            size_t sizeClass = 0;
+            while ((MIN_CAPACITY << sizeClass) < count) {
+                sizeClass++;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!spare[sizeClass].empty()) {
+                    faces = std::move(spare[sizeClass].back());
+                    spare[sizeClass].pop_back();
+                    spareBytes -= faces.capacity() * sizeof(PackedFace);
+                    memory.resize(spareBytes);
+                    return;
+                }
+            }
+            // None to spare, a new high for this size: grow it by an eighth
+            // at once, so peaks slightly above it later on still find spares.
+            // The spare list gets room for every buffer of the size, so
+            // releasing them never allocates.
+            size_t extraCount;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                extraCount = std::max<size_t>(1, bufferCounts[sizeClass] / 8);
+                bufferCounts[sizeClass] += extraCount + 1;
+                if (spare[sizeClass].capacity() < bufferCounts[sizeClass]) {
+                    spare[sizeClass].reserve(2 * bufferCounts[sizeClass]);
+                }
+            }
+            faces.reserve(MIN_CAPACITY << sizeClass);
+            for (size_t i = 0; i < extraCount; i++) {
+                std::vector<PackedFace> extra;
+                extra.reserve(MIN_CAPACITY << sizeClass);
+                release(extra);
+            }
+        }
+        
+        void trim() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t sizeClass = 0; sizeClass < CLASS_COUNT; sizeClass++) {
+                bufferCounts[sizeClass] -= std::min(bufferCounts[sizeClass], spare[sizeClass].size());
+                spare[sizeClass].clear();
+            }
+            spareBytes = 0;
+            memory.resize(0);
+        }
+        
+    private:
+        static const size_t MIN_CAPACITY = 64;
+        static const size_t CLASS_COUNT = 16;
+        
+        static size_t getSizeClass(size_t capacity) {
+            size_t sizeClass = 0;
+            while (sizeClass < CLASS_COUNT && (MIN_CAPACITY << (sizeClass + 1)) <= capacity) {
+                sizeClass++;
+            }
+            return sizeClass;
+        }
+        
+        std::mutex mutex;
+        std::array<std::vector<std::vector<PackedFace>>, CLASS_COUNT> spare;
+        std::array<size_t, CLASS_COUNT> bufferCounts{};  // Allocated here, live and spare
+        size_t spareBytes = 0;
+        TrackedAllocation memory{MemoryTag::ChunkMeshes};
+    };
+    
+    // Faces of a mesh being built, kept apart by render layer until finish()
+    // lays them out in Mesh order
+    class LayeredFaceBuilder {
+    public:
+        void add(unsigned int blockId, PackedFace face) {
+            layers[static_cast<unsigned int>(blockDatabase.getRenderLayer(blockId))].push_back(face);
+        }
+        
+        // Replace the mesh's faces and layer starts with the collected faces,
+        // and empty the builder for the next mesh
+        void finish(Chunk::Mesh& mesh) {
+            size_t total = 0;
+            for (const auto& layer : layers) {
+                total += layer.size();
+            }
+            mesh.faces.clear();
+            FaceBufferPool::getInstance().acquire(mesh.faces, total);
+            for (unsigned int layer = 0; layer < RENDER_LAYER_COUNT; layer++) {
+                mesh.layerStarts[layer] = static_cast<uint32_t>(mesh.faces.size());
+                mesh.faces.insert(mesh.faces.end(), layers[layer].begin(), layers[layer].end());
+                layers[layer].clear();
+            }
+            mesh.layerStarts[RENDER_LAYER_COUNT] = static_cast<uint32_t>(mesh.faces.size());
+        }
+        
+    private:
+        std::array<std::vector<PackedFace>, RENDER_LAYER_COUNT> layers;
+    };
+    
+    // Source of chunk versions. Versions are unique across chunks, so a mesh
+    // built for an unloaded chunk never matches one later loaded in its place.
+    // Chunks are only modified on the main thread.
+    uint64_t nextChunkVersion = 1;
+}
+
+Chunk::Chunk(int chunkX, int chunkY, int chunkZ, float voxelScale)
+    : chunkX(chunkX), chunkY(chunkY), chunkZ(chunkZ), voxelScale(voxelScale),
+      activeLod(0), version(nextChunkVersion++),
+      storageMemory(MemoryTag::ChunkBlocks, sizeof(blocks) + sizeof(blockLight)),
+      meshMemory(MemoryTag::ChunkMeshes) {
     // Initialize all blocks to air (0)
     blocks.fill(0);
+    blockLight.fill(0);
+    
+    // No level has a mesh yet
+    meshVersions.fill(0);
+    
+    // Occluders come from full-resolution meshes only, at most one box per
+    // group of columns
+    meshes[0].occluders.reserve((CHUNK_SIZE_X / OCCLUDER_CELL_SIZE) * (CHUNK_SIZE_Z / OCCLUDER_CELL_SIZE));
+    updateMeshMemory();
+}
+
+void Chunk::reset(int chunkX, int chunkY, int chunkZ) {
+    this->chunkX = chunkX;
+    this->chunkY = chunkY;
+    this->chunkZ = chunkZ;
+    blocks.fill(0);
+    blockLight.fill(0);
+    
+    for (Mesh& mesh : meshes) {
+        mesh.clear();
+    }
+    meshVersions.fill(0);
+    activeLod = 0;
+    version = nextChunkVersion++;
+    sharedSnapshot.reset();
+    updateMeshMemory();
 }
 
 glm::vec3 Chunk::toWorldPosition(int localX, int localY, int localZ) const {
     // Convert local coordinates to world coordinates
     float worldX = (chunkX * CHUNK_SIZE_X + localX) * voxelScale;
-    float worldY = localY * voxelScale;
+    float worldY = (chunkY * CHUNK_SIZE_Y + localY) * voxelScale;
     float worldZ = (chunkZ * CHUNK_SIZE_Z + localZ) * voxelScale;
     
     return glm::vec3(worldX, worldY, worldZ);
@@ -18,14 +368,15 @@ glm::vec3 Chunk::toWorldPosition(int localX, int localY, int localZ) const {
 
 bool Chunk::toLocalPosition(const glm::vec3& worldPos, int& localX, int& localY, int& localZ) const {
     // Convert world position to chunk-local coordinates
-    // First, convert to voxel coordinates (integer)
-    int voxelX = static_cast<int>(worldPos.x / voxelScale);
-    int voxelY = static_cast<int>(worldPos.y / voxelScale);
-    int voxelZ = static_cast<int>(worldPos.z / voxelScale);
+    // First, convert to voxel coordinates (integer), rounding down like
+    // ChunkManager::worldToChunkCoords so positions below zero agree
+    int voxelX = static_cast<int>(std::floor(worldPos.x / voxelScale));
+    int voxelY = static_cast<int>(std::floor(worldPos.y / voxelScale));
+    int voxelZ = static_cast<int>(std::floor(worldPos.z / voxelScale));
     
     // Then, convert to local coordinates
     localX = voxelX - chunkX * CHUNK_SIZE_X;
-    localY = voxelY;
+    localY = voxelY - chunkY * CHUNK_SIZE_Y;
     localZ = voxelZ - chunkZ * CHUNK_SIZE_Z;
     
     // Check if the coordinates are within this chunk
@@ -43,17 +394,11 @@ bool Chunk::isValidLocalPosition(int localX, int localY, int localZ) const {
            localZ >= 0 && localZ < CHUNK_SIZE_Z;
 }
 
-int Chunk::getBlockIndex(int localX, int localY, int localZ) const {
-    return localX + 
-           localY * CHUNK_SIZE_X + 
-           localZ * CHUNK_SIZE_X * CHUNK_SIZE_Y;
-}
-
 void Chunk::setVoxel(int localX, int localY, int localZ, unsigned int blockId) {
     if (isValidLocalPosition(localX, localY, localZ)) {
         int index = getBlockIndex(localX, localY, localZ);
         blocks[index] = blockId;
-        isDirty = true;
+        markDirty();
     }
 }
 
@@ -66,64 +411,302 @@ unsigned int Chunk::getVoxelBlockId(int localX, int localY, int localZ) const {
 }
 
 bool Chunk::isVoxelSolid(int localX, int localY, int localZ) const {
-    // Air (blockId = 0) is not solid
-    // Water (blockId = 7) is semi-transparent, but we'll consider it non-solid for face culling
-    unsigned int blockId = getVoxelBlockId(localX, localY, localZ);
-    return blockId != 0 && blockId != 7;
+    return blockDatabase.isSolid(getVoxelBlockId(localX, localY, localZ));
 }
 
-bool Chunk::isFaceVisible(int localX, int localY, int localZ, int dx, int dy, int dz) const {
-    // Check if neighboring voxel exists and is non-solid
-    int nx = localX + dx;
-    int ny = localY + dy;
-    int nz = localZ + dz;
-    
-    // If neighboring position is outside chunk bounds, consider the face visible
-    if (!isValidLocalPosition(nx, ny, nz)) {
-        return true;
+unsigned char Chunk::getBlockLight(int localX, int localY, int localZ) const {
+    if (isValidLocalPosition(localX, localY, localZ)) {
+        return blockLight[getBlockIndex(localX, localY, localZ)];
+    }
+    return 0;
+}
+
+void Chunk::setBlockLight(int localX, int localY, int localZ, unsigned char level) {
+    if (isValidLocalPosition(localX, localY, localZ)) {
+        blockLight[getBlockIndex(localX, localY, localZ)] = level;
+    }
+}
+
+unsigned char Chunk::sampleVoxelLight(int localX, int localY, int localZ, const Neighbors& neighbors) const {
+    // Solid voxels hold no light themselves, so take the brightest of the
+    // voxel and its six neighbours (the cells its visible faces look into).
+    // Cells across the border are read from the neighbouring chunk.
+    unsigned char level = blockLight[getBlockIndex(localX, localY, localZ)];
+    for (unsigned int face = 0; face < BlockDatabase::FACE_COUNT; face++) {
+        int nx = localX + FACE_OFFSETS[face][0];
+        int ny = localY + FACE_OFFSETS[face][1];
+        int nz = localZ + FACE_OFFSETS[face][2];
+        if (isValidLocalPosition(nx, ny, nz)) {
+            level = std::max(level, blockLight[getBlockIndex(nx, ny, nz)]);
+        } else if (const Chunk* neighbor = neighbors[face]) {
+            level = std::max(level, neighbor->blockLight[getBlockIndex((nx + CHUNK_SIZE_X) % CHUNK_SIZE_X,
+                                                                       (ny + CHUNK_SIZE_Y) % CHUNK_SIZE_Y,
+                                                                       (nz + CHUNK_SIZE_Z) % CHUNK_SIZE_Z)]);
+        }
+    }
+    return level;
+}
+
+bool Chunk::isFaceVisible(unsigned int blockId, int localX, int localY, int localZ, unsigned int face,
+                          const Neighbors& neighbors) const {
+    int nx = localX + FACE_OFFSETS[face][0];
+    int ny = localY + FACE_OFFSETS[face][1];
+    int nz = localZ + FACE_OFFSETS[face][2];
+    if (isValidLocalPosition(nx, ny, nz)) {
+        return isFaceShown(blockId, true, blocks[getBlockIndex(nx, ny, nz)], face);
     }
     
-    // Check if the neighboring voxel is non-solid (air or water)
-    return !isVoxelSolid(nx, ny, nz);
+    // Across the border the voxel facing this one is on the neighbour's
+    // opposite side
+    const Chunk* neighbor = neighbors[face];
+    if (!neighbor) {
+        return isFaceShown(blockId, false, 0, face);
+    }
+    unsigned int neighborId = neighbor->blocks[getBlockIndex((nx + CHUNK_SIZE_X) % CHUNK_SIZE_X,
+                                                             (ny + CHUNK_SIZE_Y) % CHUNK_SIZE_Y,
+                                                             (nz + CHUNK_SIZE_Z) % CHUNK_SIZE_Z)];
+    return isFaceShown(blockId, true, neighborId, face);
+}
+
+void Chunk::markDirty() {
+    version = nextChunkVersion++;
+}
+
+void Chunk::releaseSpareFaceBuffers() {
+    FaceBufferPool::getInstance().trim();
 }
 
-std::vector<Voxel> Chunk::generateMesh() {
-    // Clear the previous mesh
-    chunkMesh.clear();
+void Chunk::Mesh::clear() {
+    FaceBufferPool::getInstance().release(faces);
+    occluders.clear();
+    layerStarts.fill(0);
+    connectivity = ALL_SIDES_CONNECTED;
+    sharedSides = 0;
+}
+
+void Chunk::takeSnapshot(VoxelSnapshot& snapshot) const {
+    snapshot.chunkX = chunkX;
+    snapshot.chunkY = chunkY;
+    snapshot.chunkZ = chunkZ;
+    snapshot.version = version;
+    snapshot.blocks = blocks;
+    snapshot.blockLight = blockLight;
+}
+
+const Chunk::Mesh& Chunk::generateMesh(const Neighbors& neighbors) {
+    PROFILE_FUNCTION();
     
-    // Iterate through all blocks in the chunk
+    Mesh& mesh = meshes[0];
+    thread_local LayeredFaceBuilder builder;
+    
+    // Iterate through the blocks, noting which are opaque for the chunk's
+    // connectivity and the occluder boxes
+    std::array<unsigned char, CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z> opaque;
+    ColumnMasks columnOpaque{};
     for (int x = 0; x < CHUNK_SIZE_X; x++) {
         for (int y = 0; y < CHUNK_SIZE_Y; y++) {
             for (int z = 0; z < CHUNK_SIZE_Z; z++) {
-                unsigned int blockId = getVoxelBlockId(x, y, z);
+                unsigned int blockId = blocks[getBlockIndex(x, y, z)];
+                bool blockOpaque = blockDatabase.isOpaque(blockId);
+                opaque[getBlockIndex(x, y, z)] = blockOpaque;
+                columnOpaque[x + z * CHUNK_SIZE_X] |= uint64_t(blockOpaque) << y;
                 
                 // Skip air blocks
                 if (blockId == 0) {
                     continue;
                 }
                 
-                // Calculate world position for this voxel
-                glm::vec3 position = toWorldPosition(x, y, z);
-                
-                // Only add visible faces (basic culling)
-                // We only add a voxel if at least one of its faces is visible
-                bool hasVisibleFace = 
-                    isFaceVisible(x, y, z, 0, 0, -1) || // Back face (-Z)
-                    isFaceVisible(x, y, z, 0, 0, 1) ||  // Front face (+Z)
-                    isFaceVisible(x, y, z, -1, 0, 0) || // Left face (-X)
-                    isFaceVisible(x, y, z, 1, 0, 0) ||  // Right face (+X)
-                    isFaceVisible(x, y, z, 0, -1, 0) || // Bottom face (-Y)
-                    isFaceVisible(x, y, z, 0, 1, 0);    // Top face (+Y)
-                
-                if (hasVisibleFace) {
-                    chunkMesh.emplace_back(position, blockId);
+                // Emit only the faces that are not hidden by a neighbour. The
+                // light is sampled once, when the first visible face is found.
+                int light = -1;
+                for (unsigned int face = 0; face < BlockDatabase::FACE_COUNT; face++) {
+                    if (!isFaceVisible(blockId, x, y, z, face, neighbors)) {
+                        continue;
+                    }
+                    if (light < 0) {
+                        light = sampleVoxelLight(x, y, z, neighbors);
+                    }
+                    builder.add(blockId, packFace(x, y, z, face, blockId, static_cast<uint32_t>(light)));
+                }
+            }
+        }
+    }
+    mesh.connectivity = computeConnectivity(CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SIZE_Z, opaque.data());
+    builder.finish(mesh);
+    findOccluderBoxes(columnOpaque, mesh.occluders);
+    
+    // Mark the mesh as up-to-date
+    meshVersions[0] = version;
+    updateMeshMemory();
+    
+    return mesh;
+}
+
+void Chunk::generateLodMesh(const VoxelSnapshot& snapshot, int level, Mesh& mesh, const NeighborSnapshots& neighbors) {
+    PROFILE_FUNCTION();
+    
+    const int cellSize = getLodCellSize(level);
+    const int cellVolume = cellSize * cellSize * cellSize;
+    const int cellsX = CHUNK_SIZE_X / cellSize;
+    const int cellsY = CHUNK_SIZE_Y / cellSize;
+    const int cellsZ = CHUNK_SIZE_Z / cellSize;
+    auto cellIndex = [&](int x, int y, int z) { return x + y * cellsX + z * cellsX * cellsY; };
+    
+    // Reduce a cell to one block. A cell is filled when at least half of its
+    // voxels are, and is lit by its brightest voxel.
+    auto reduceCell = [&](const VoxelSnapshot& source, int cx, int cy, int cz) {
+        LodCell cell;
+        int filled = 0;
+        for (int y = 0; y < cellSize; y++) {
+            for (int z = 0; z < cellSize; z++) {
+                for (int x = 0; x < cellSize; x++) {
+                    int index = getBlockIndex(cx * cellSize + x, cy * cellSize + y, cz * cellSize + z);
+                    unsigned int blockId = source.blocks[index];
+                    cell.light = std::max(cell.light, source.blockLight[index]);
+                    if (blockId != 0) {
+                        filled++;
+                        cell.top = blockId;
+                        if (cell.bottom == 0) {
+                            cell.bottom = blockId;
+                        }
+                    }
                 }
             }
         }
+        cell.filled = filled * 2 >= cellVolume;
+        return cell;
+    };
+    
+    const size_t cellCount = cellsX * cellsY * cellsZ;
+    thread_local LodCellBuffers cells;
+    std::vector<LodCell>& reduced = cells.reduced;
+    std::vector<unsigned int>& cellBlocks = cells.blocks;
+    reduced.resize(cellCount);
+    cellBlocks.assign(cellCount, 0);
+    for (int cz = 0; cz < cellsZ; cz++) {
+        for (int cy = 0; cy < cellsY; cy++) {
+            for (int cx = 0; cx < cellsX; cx++) {
+                reduced[cellIndex(cx, cy, cz)] = reduceCell(snapshot, cx, cy, cz);
+            }
+        }
     }
     
-    // Mark chunk as up-to-date
-    isDirty = false;
+    // Filled cells show their highest voxel, so grass and sand surfaces keep
+    // their colour from afar. When the surface layer lies in the thinly
+    // filled cell above, the cell shows that layer (the lowest voxel up
+    // there) instead of the dirt or stone under it.
+    auto shownBlock = [&](const LodCell& cell, const LodCell* above) {
+        if (!cell.filled) {
+            return 0u;
+        }
+        if (above && !above->filled && above->bottom != 0) {
+            return above->bottom;
+        }
+        return cell.top;
+    };
+    for (int cz = 0; cz < cellsZ; cz++) {
+        for (int cy = 0; cy < cellsY; cy++) {
+            for (int cx = 0; cx < cellsX; cx++) {
+                const LodCell* above = cy + 1 < cellsY ? &reduced[cellIndex(cx, cy + 1, cz)] : nullptr;
+                cellBlocks[cellIndex(cx, cy, cz)] = shownBlock(reduced[cellIndex(cx, cy, cz)], above);
+            }
+        }
+    }
     
-    return chunkMesh;
-}
\ No newline at end of file
+    // Block shown by the cell of a neighbour across the border, reduced from
+    // its snapshot the same way as the neighbour's own mesh
+    auto neighborCellBlock = [&](const VoxelSnapshot& neighbor, int cx, int cy, int cz) {
+        LodCell above;
+        if (cy + 1 < cellsY) {
+            above = reduceCell(neighbor, cx, cy + 1, cz);
+        }
+        return shownBlock(reduceCell(neighbor, cx, cy, cz), cy + 1 < cellsY ? &above : nullptr);
+    };
+    
+    // Mesh the cells like voxels. Faces on the chunk's sides are culled only
+    // against neighbours drawn at the same level. Elsewhere they are emitted
+    // (water's aside), which closes the chunk like a skirt: where rings of
+    // different levels meet, their surfaces may step by a cell but never
+    // leave a gap to see through.
+    mesh.clear();
+    thread_local LayeredFaceBuilder builder;
+    // Sides with border faces; only those share with a neighbour
+    unsigned int borderSides = 0;
+    for (int cx = 0; cx < cellsX; cx++) {
+        for (int cy = 0; cy < cellsY; cy++) {
+            for (int cz = 0; cz < cellsZ; cz++) {
+                unsigned int blockId = cellBlocks[cellIndex(cx, cy, cz)];
+                if (blockId == 0) {
+                    continue;
+                }
+                
+                uint32_t light = reduced[cellIndex(cx, cy, cz)].light;
+                for (unsigned int face = 0; face < BlockDatabase::FACE_COUNT; face++) {
+                    const int* offset = FACE_OFFSETS[face];
+                    int nx = cx + offset[0];
+                    int ny = cy + offset[1];
+                    int nz = cz + offset[2];
+                    bool inside = nx >= 0 && nx < cellsX && ny >= 0 && ny < cellsY && nz >= 0 && nz < cellsZ;
+                    unsigned int neighborId = 0;
+                    if (inside) {
+                        neighborId = cellBlocks[cellIndex(nx, ny, nz)];
+                    } else {
+                        borderSides |= 1u << face;
+                        if (neighbors[face]) {
+                            neighborId = neighborCellBlock(*neighbors[face], (nx + cellsX) % cellsX,
+                                                           (ny + cellsY) % cellsY, (nz + cellsZ) % cellsZ);
+                        }
+                    }
+                    if (!isFaceShown(blockId, inside || neighbors[face] != nullptr, neighborId, face)) {
+                        continue;
+                    }
+                    
+                    // Faces that look into a neighbouring cell take its light too
+                    uint32_t faceLight = inside ? std::max<uint32_t>(light, reduced[cellIndex(nx, ny, nz)].light) : light;
+                    builder.add(blockId, packFace(cx, cy, cz, face, blockId, faceLight));
+                }
+            }
+        }
+    }
+    builder.finish(mesh);
+    for (unsigned int face = 0; face < BlockDatabase::FACE_COUNT; face++) {
+        if (neighbors[face] && (borderSides & (1u << face))) {
+            mesh.sharedSides |= 1u << face;
+        }
+    }
+    
+    // Visibility follows the cells as drawn, not the full-resolution
+    // voxels, which may stand above a cell's surface or leave gaps in it
+    std::vector<unsigned char>& cellOpaque = cells.opaque;
+    cellOpaque.resize(cellCount);
+    for (size_t cell = 0; cell < cellCount; cell++) {
+        cellOpaque[cell] = blockDatabase.isOpaque(cellBlocks[cell]);
+    }
+    mesh.connectivity = computeConnectivity(cellsX, cellsY, cellsZ, cellOpaque.data());
+}
+
+void Chunk::setLodMesh(int level, Mesh& mesh, uint64_t builtVersion) {
+    std::swap(meshes[level], mesh);
+    mesh.clear();
+    meshVersions[level] = builtVersion;
+    updateMeshMemory();
+}
+
+void Chunk::setActiveLod(int level) {
+    activeLod = level;
+    for (int other = 0; other < LOD_LEVELS; other++) {
+        if (other != level) {
+            meshes[other].clear();
+            meshVersions[other] = 0;
+        }
+    }
+    updateMeshMemory();
+}
+
+void Chunk::updateMeshMemory() {
+    size_t bytes = 0;
+    for (const auto& mesh : meshes) {
+        bytes += mesh.faces.capacity() * sizeof(PackedFace) + mesh.occluders.capacity() * sizeof(OccluderBox);
+    }
+    meshMemory.resize(bytes);
+}
@@ -2,29 +2,40 @@
 #define CHUNK_H
 
 #include <vector>
+#include <cstdint>
 #include <array>
 #include <memory>
 #include <unordered_map>
 #include <glm/glm.hpp>
 #include "Voxel.h"
+#include "PackedFace.h"
+#include "BlockDatabase.h"
+#include "../Utils/MemoryTracker.h"
 
 // Forward declarations
 class ChunkManager;
 
 class Chunk {
 public:
-    // Constants for chunk dimensions
-    static const int CHUNK_SIZE_X = 16;
-    static const int CHUNK_SIZE_Y = 64;  // Height can be higher
-    static const int CHUNK_SIZE_Z = 16;
+    // Constants for chunk dimensions. Chunks are cubes stacked vertically
+    // without limit; chunk y 0 starts at voxel y 0.
+    static constexpr int CHUNK_SIZE_X = 16;
+    static constexpr int CHUNK_SIZE_Y = 16;
+    static constexpr int CHUNK_SIZE_Z = 16;
 
     // Constructor - takes chunk coordinates (in chunk space, not world space)
-    Chunk(int chunkX, int chunkZ, float voxelScale);
+    Chunk(int chunkX, int chunkY, int chunkZ, float voxelScale);
     ~Chunk() = default;
+    
+    // Turn the chunk into an empty one at new coordinates, as if just
+    // constructed but keeping the capacity of its mesh buffers
+    void reset(int chunkX, int chunkY, int chunkZ);
 
     // Get chunk coordinates
     int getChunkX() const { return chunkX; }
+    int getChunkY() const { return chunkY; }
     int getChunkZ() const { return chunkZ; }
+    glm::ivec3 getCoords() const { return glm::ivec3(chunkX, chunkY, chunkZ); }
     
     // Convert local coordinates to world coordinates
     glm::vec3 toWorldPosition(int localX, int localY, int localZ) const;
@@ -43,38 +54,176 @@ public:
     unsigned int getVoxelBlockId(int localX, int localY, int localZ) const;
     bool isVoxelSolid(int localX, int localY, int localZ) const;
     
-    // Generate mesh for this chunk
-    std::vector<Voxel> generateMesh();
+    // Store a block without giving the chunk a new version and return the
+    // block it replaced. Bulk edits write through this and call markDirty()
+    // once at the end. The position must be valid.
+    unsigned int exchangeVoxel(int localX, int localY, int localZ, unsigned int blockId) {
+        unsigned int& block = blocks[getBlockIndex(localX, localY, localZ)];
+        unsigned int previous = block;
+        block = blockId;
+        return previous;
+    }
+
+    // Block light operations (0 = dark, 15 = brightest)
+    unsigned char getBlockLight(int localX, int localY, int localZ) const;
+    void setBlockLight(int localX, int localY, int localZ, unsigned char level);
+    
+    // Mesh detail levels. Level n merges 2^n x 2^n x 2^n voxels into one cell,
+    // so far chunks can be drawn with a fraction of their faces.
+    static const int LOD_LEVELS = 3;
+    static int getLodCellSize(int level) { return 1 << level; }
+    
+    // Which pairs of a chunk's six sides (BlockFace order) are joined by a
+    // path through non-opaque voxels: bit a * 6 + b is set when side a can be
+    // seen from side b. Chunks are the unit of visibility culling.
+    using Connectivity = uint64_t;
+    static constexpr Connectivity ALL_SIDES_CONNECTED = (uint64_t(1) << 36) - 1;
+    static bool sidesConnected(Connectivity connectivity, int sideA, int sideB) {
+        return (connectivity >> (sideA * 6 + sideB)) & 1;
+    }
+    
+    // Box of voxels that are all opaque, in chunk-local voxel coordinates
+    // (max exclusive). Anything it hides on screen is hidden by the mesh.
+    struct OccluderBox {
+        uint8_t minX, minY, minZ;
+        uint8_t maxX, maxY, maxZ;
+    };
+    
+    // Occluder boxes are found per column group of this many voxels square
+    static const int OCCLUDER_CELL_SIZE = 4;
+    
+    // A built mesh of one detail level. Meshes are only moved, never copied,
+    // and are rebuilt in place so their buffers are reused.
+    struct Mesh {
+        std::vector<PackedFace> faces;
+        // Faces are grouped by render layer (BlockDatabase's RenderLayer
+        // order); those of layer l are [layerStarts[l], layerStarts[l + 1])
+        std::array<uint32_t, RENDER_LAYER_COUNT + 1> layerStarts;
+        // Connectivity of the chunk, from the blocks the mesh was built from
+        Connectivity connectivity = ALL_SIDES_CONNECTED;
+        // Reduced levels only, a bit per BlockFace: sides whose border faces
+        // were culled against a neighbour drawn at the same level
+        uint8_t sharedSides = 0;
+        // Solid boxes for software occlusion culling; full resolution only
+        std::vector<OccluderBox> occluders;
+        
+        Mesh() {
+            layerStarts.fill(0);
+        }
+        Mesh(Mesh&&) = default;
+        Mesh& operator=(Mesh&&) = default;
+        Mesh(const Mesh&) = delete;
+        Mesh& operator=(const Mesh&) = delete;
+        
+        // Back to an empty mesh; the face buffer goes to a pool shared by all
+        // meshes, the occluder buffer keeps its capacity
+        void clear();
+    };
+    
+    using BlockArray = std::array<unsigned int, CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z>;
+    
+    // Block ids and light of one chunk version, copied out so other threads
+    // can read them while the chunk keeps changing. Snapshots are shared as
+    // SnapshotPtr and never change once shared (see SnapshotPool).
+    struct VoxelSnapshot {
+        int chunkX = 0;
+        int chunkY = 0;
+        int chunkZ = 0;
+        uint64_t version = 0;
+        BlockArray blocks;
+        std::array<unsigned char, CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z> blockLight;
+    };
+    using SnapshotPtr = std::shared_ptr<const VoxelSnapshot>;
+    void takeSnapshot(VoxelSnapshot& snapshot) const;
+    
+    // The snapshot of the current version while anyone still holds it, so
+    // it can be shared instead of copied again; null otherwise
+    SnapshotPtr getSharedSnapshot() const {
+        SnapshotPtr snapshot = sharedSnapshot.lock();
+        return snapshot && snapshot->version == version ? snapshot : nullptr;
+    }
+    void setSharedSnapshot(const SnapshotPtr& snapshot) { sharedSnapshot = snapshot; }
     
-    // Check if chunk needs remeshing after block changes
-    bool needsRemesh() const { return isDirty; }
-    void markDirty() { isDirty = true; }
+    // Loaded neighbours in BlockFace order, null where there is none or it
+    // holds only air
+    using Neighbors = std::array<const Chunk*, BlockDatabase::FACE_COUNT>;
     
-    // Get reference to voxel data
-    const std::vector<Voxel>& getVoxels() const { return chunkMesh; }
+    // Generate the full-resolution (level 0) mesh: one packed entry per
+    // visible face. Border faces against an opaque voxel of a given
+    // neighbour are left out, so the chunk must be marked dirty when a
+    // neighbour is loaded or unloaded.
+    const Mesh& generateMesh(const Neighbors& neighbors = Neighbors{});
     
-    // Return true if chunk has any visible voxels
-    bool hasVisibleVoxels() const { return !chunkMesh.empty(); }
+    // Snapshots of a chunk's neighbours in BlockFace order; null where there
+    // is none to build against
+    using NeighborSnapshots = std::array<const VoxelSnapshot*, BlockDatabase::FACE_COUNT>;
+    
+    // Generate the mesh of a reduced level from a snapshot into mesh, reusing
+    // its buffers. Border faces are culled against the given neighbours,
+    // which must be drawn at the same level, and kept on the other sides.
+    // Touches no chunk state, so it is safe to call from any thread.
+    static void generateLodMesh(const VoxelSnapshot& snapshot, int level, Mesh& mesh,
+                                const NeighborSnapshots& neighbors = NeighborSnapshots{});
+    
+    // Free the face buffers pooled by cleared meshes
+    static void releaseSpareFaceBuffers();
+    
+    // Every block or light change gives the chunk a new version; a mesh is
+    // current while it was built from the chunk's present version
+    uint64_t getVersion() const { return version; }
+    bool needsRemesh(int level = 0) const { return meshVersions[level] != version; }
+    
+    // Whether the active level has been meshed since the chunk was loaded
+    bool hasMesh() const { return meshVersions[activeLod] != 0; }
+    void markDirty();
+    
+    // Swap in a mesh built elsewhere from the given version. mesh is left
+    // holding the level's previous buffers, emptied, for the next build.
+    void setLodMesh(int level, Mesh& mesh, uint64_t builtVersion);
+    
+    // Level returned by getMesh. The meshes of the other levels are emptied
+    // but keep their buffers, so moving between levels does not reallocate.
+    void setActiveLod(int level);
+    int getActiveLod() const { return activeLod; }
+    
+    // Mesh of the active level
+    const Mesh& getMesh() const { return meshes[activeLod]; }
+    
+    // Return true if the active level has any visible faces
+    bool hasVisibleFaces() const { return !meshes[activeLod].faces.empty(); }
 
 private:
     // Chunk coordinates (in chunk space)
-    int chunkX, chunkZ;
+    int chunkX, chunkY, chunkZ;
     
     // Scale factor for voxels
     float voxelScale;
     
     // 3D array of block IDs (0 = air/empty)
-    std::array<unsigned int, CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z> blocks;
+    BlockArray blocks;
+
+    // Block light level per voxel, filled in by ChunkManager's flood fill
+    std::array<unsigned char, CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z> blockLight;
     
-    // Generated mesh for rendering
-    std::vector<Voxel> chunkMesh;
+    // Generated mesh of each detail level and the version it was built from
+    std::array<Mesh, LOD_LEVELS> meshes;
+    std::array<uint64_t, LOD_LEVELS> meshVersions;
+    int activeLod;
+    uint64_t version;
+    std::weak_ptr<const VoxelSnapshot> sharedSnapshot;
     
-    // Flag indicating if mesh needs to be regenerated
-    bool isDirty;
+    // Memory accounting for block storage and the cached mesh
+    TrackedAllocation storageMemory;
+    TrackedAllocation meshMemory;
     
     // Helper methods
-    int getBlockIndex(int localX, int localY, int localZ) const;
-    bool isFaceVisible(int localX, int localY, int localZ, int dx, int dy, int dz) const;
+    static int getBlockIndex(int localX, int localY, int localZ) {
+        return localX + localY * CHUNK_SIZE_X + localZ * CHUNK_SIZE_X * CHUNK_SIZE_Y;
+    }
+    bool isFaceVisible(unsigned int blockId, int localX, int localY, int localZ, unsigned int face,
+                       const Neighbors& neighbors) const;
+    unsigned char sampleVoxelLight(int localX, int localY, int localZ, const Neighbors& neighbors) const;
+    void updateMeshMemory();
 };
 
 #endif // CHUNK_H
\ No newline at end of file
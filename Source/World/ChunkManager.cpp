@@ -1,50 +1,432 @@
 #include "ChunkManager.h"
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <limits>
 #include "stb_perlin.h"
+#include "BlockDatabase.h"
+#include "../Utils/Profiler.h"
 
-ChunkManager::ChunkManager(Config& config) 
-    : config(config), 
-      viewDistanceInChunks(16),  // Default view distance of 8 chunks
-      voxelScale(config.voxelScale) {
+namespace {
+    // Neighbour offsets used by the light flood fill
+    const int LIGHT_DX[6] = {-1, 1, 0, 0, 0, 0};
+    const int LIGHT_DY[6] = {0, 0, -1, 1, 0, 0};
+    const int LIGHT_DZ[6] = {0, 0, 0, 0, -1, 1};
+
+    // Step to the neighbouring chunk across each side, in BlockFace order
+    // (TOP, BOTTOM, FRONT, BACK, LEFT, RIGHT). The visibility search steps
+    // between the cells of its grid the same way.
+    const ChunkCoord SIDE_STEPS[6] = {
+        {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {-1, 0, 0}, {1, 0, 0}
+    };
+
+    static_assert(Chunk::CHUNK_SIZE_X == Chunk::CHUNK_SIZE_Y && Chunk::CHUNK_SIZE_Y == Chunk::CHUNK_SIZE_Z,
+                  "Chunk borders are walked as square layers");
+
+    // Integer division rounding towards negative infinity
+    int floorDiv(int value, int divisor) {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    bool isLightTransparent(unsigned int blockId) {
+        return BlockDatabase::getInstance().isTransparent(blockId);
+    }
+
+    unsigned char getEmission(unsigned int blockId) {
+        return BlockDatabase::getInstance().getEmission(blockId);
+    }
+
+    // Slower cameras are not prefetched for, in world units per second
+    const float MIN_PREFETCH_SPEED = 0.5f;
+
+    // Chunks a column's terrain is expected to span beyond the vertical
+    // view, for sizing the chunk pool
+    const int SURFACE_CHUNKS_PER_COLUMN = 4;
+
+    const int WATER_LEVEL = 12;
+    const float TREE_DENSITY = 0.01f;
+    // Trees stand where the density field is this clearly solid below and
+    // air above, so rounding in the chunks' sampling cannot disagree
+    const float TREE_DENSITY_MARGIN = 0.1f;
+
+    // Solid flags of the chunk being generated. Each generating thread
+    // allocates one on first use and keeps it.
+    struct TerrainScratch {
+        DensityField::SolidMask solid;
+        TrackedAllocation memory{MemoryTag::GenerationScratch, sizeof(TerrainScratch)};
+    };
+
+    // Entry for key, added in a node left over from an erased entry when
+    // there is one. A new entry's value is stale and must be set.
+    template <typename Map>
+    typename Map::iterator insertReusingNode(Map& map, std::vector<typename Map::node_type>& spareNodes,
+                                             const typename Map::key_type& key) {
+        if (spareNodes.empty()) {
+            return map.try_emplace(key).first;
+        }
+        typename Map::node_type node = std::move(spareNodes.back());
+        spareNodes.pop_back();
+        node.key() = key;
+        auto result = map.insert(std::move(node));
+        if (!result.inserted) {
+            spareNodes.push_back(std::move(result.node));
+        }
+        return result.position;
+    }
+
+    // Deterministic value in [0, 1) for a voxel column, so every chunk of a
+    // column agrees on where its trees stand, in whatever order they load
+    float columnRandom(int voxelX, int voxelZ) {
+        uint32_t hash = static_cast<uint32_t>(voxelX) * 73856093u ^ static_cast<uint32_t>(voxelZ) * 19349663u;
+        hash ^= hash >> 13;
+        hash *= 0x5bd1e995u;
+        hash ^= hash >> 15;
+        return (hash & 0xffffff) / 16777216.0f;
+    }
+
+    uint64_t steadyNowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
+
+ChunkManager::ChunkManager(Config& config)
+    : config(config),
+      residencyGovernor(config),
+      viewDistanceInChunks(residencyGovernor.getViewDistance()),
+      verticalViewDistance(std::max(0, config.streaming.verticalViewDistance)),
+      voxelScale(config.voxelScale),
+      chunkPool(static_cast<size_t>(((2 * residencyGovernor.getMaxViewDistance() + 1) *
+                                     (2 * residencyGovernor.getMaxViewDistance() + 1) +
+                                     (config.prefetch.enabled ? std::max(0, config.prefetch.maxChunks) : 0)) *
+                                    (2 * verticalViewDistance + 1 + SURFACE_CHUNKS_PER_COLUMN) +
+                                    (config.prefetch.enabled ? std::max(0, config.prefetch.maxChunks) : 0)),
+                config.voxelScale, config.performance.chunkPoolHugePages),
+      snapshotPool(SnapshotPool::create()),
+      workerPool(static_cast<unsigned int>(std::max(0, config.performance.workerThreads))) {
 }
 
 void ChunkManager::init(Biome& biome) {
     this->biome = &biome;
 }
 
-void ChunkManager::loadChunk(int chunkX, int chunkZ) {
-    std::pair<int, int> key = std::make_pair(chunkX, chunkZ);
-    if (chunks.find(key) == chunks.end()) {
-        // Create a new chunk
-        auto chunk = std::make_shared<Chunk>(chunkX, chunkZ, voxelScale);
-        chunks[key] = chunk;
-        
-        // Generate terrain for this chunk
-        generateTerrainForChunk(chunkX, chunkZ);
+void ChunkManager::loadChunk(int chunkX, int chunkY, int chunkZ) {
+    PROFILE_FUNCTION();
+    
+    beginLoadChunk(chunkX, chunkY, chunkZ);
+    generatePendingTerrain();
+}
+
+void ChunkManager::beginLoadChunk(int chunkX, int chunkY, int chunkZ) {
+    ChunkCoord coords(chunkX, chunkY, chunkZ);
+    if (chunks.find(coords) != chunks.end()) {
+        return;
+    }
+    // Its blocks are generated afresh, without the edits neighbours that
+    // kept faces culled against it may have seen
+    remeshReducedNeighbors(coords, NeighborChange::Blocks);
+    ChunkColumn& column = loadColumnData(chunkX, chunkZ);
+    column.minLoadedY = std::min(column.minLoadedY, chunkY);
+    column.maxLoadedY = std::max(column.maxLoadedY, chunkY);
+    
+    // Chunks above everything the column holds are air and need no storage
+    if (chunkY * Chunk::CHUNK_SIZE_Y > column.maxContentY) {
+        insertReusingNode(chunks, spareChunkNodes, coords)->second = nullptr;
+        streamingStats.emptyChunksLoaded++;
+        return;
+    }
+    
+    // Take an empty chunk from the pool
+    Chunk* chunk = chunkPool.acquire(chunkX, chunkY, chunkZ);
+    if (!chunk) {
+        std::cerr << "Error: chunk pool of " << chunkPool.getCapacity() << " chunks is full, cannot load chunk ("
+                  << chunkX << ", " << chunkY << ", " << chunkZ << ")" << std::endl;
+        return;
+    }
+    insertReusingNode(chunks, spareChunkNodes, coords)->second = chunk;
+    insertReusingNode(pendingLoadStartNs, spareLoadStartNodes, coords)->second = steadyNowNs();
+    streamingStats.chunksLoaded++;
+    
+    pendingTerrain.push_back(coords);
+}
+
+void ChunkManager::unloadChunk(int chunkX, int chunkY, int chunkZ) {
+    ChunkCoord coords(chunkX, chunkY, chunkZ);
+    auto it = chunks.find(coords);
+    if (it == chunks.end()) {
+        return;
+    }
+    Chunk* chunk = it->second;
+    spareChunkNodes.push_back(chunks.extract(it));
+    if (chunk) {
+        chunkPool.release(chunk);
+        changedChunks.push_back(coords);
+        auto loadStart = pendingLoadStartNs.find(coords);
+        if (loadStart != pendingLoadStartNs.end()) {
+            spareLoadStartNodes.push_back(pendingLoadStartNs.extract(loadStart));
+        }
+        remeshNeighbors(coords);
+        remeshReducedNeighbors(coords, NeighborChange::Unload);
         
-        // Generate mesh
-        chunk->generateMesh();
+        auto pending = std::find(pendingTerrain.begin(), pendingTerrain.end(), coords);
+        if (pending != pendingTerrain.end()) {
+            pendingTerrain.erase(pending);
+        }
     }
 }
 
-void ChunkManager::unloadChunk(int chunkX, int chunkZ) {
-    std::pair<int, int> key = std::make_pair(chunkX, chunkZ);
-    chunks.erase(key);
+void ChunkManager::generatePendingTerrain() {
+    PROFILE_FUNCTION();
+    
+    if (pendingTerrain.empty()) {
+        return;
+    }
+    
+    // Nothing else touches the pending chunks, or changes the chunk and
+    // column maps, until the batch is done, so the workers write the
+    // chunks without locking
+    std::atomic<uint64_t> generationNs{0};
+    workerPool.parallelFor(pendingTerrain.size(), [&](size_t i) {
+        const ChunkCoord& coords = pendingTerrain[i];
+        uint64_t startNs = steadyNowNs();
+        generateTerrain(*findChunk(coords), columns.find(std::make_pair(coords.x, coords.z))->second);
+        generationNs += steadyNowNs() - startNs;
+    });
+    streamingStats.generationNs += generationNs;
+    
+    // Queue emitters and light flowing in from loaded neighbours. Chunk
+    // versions are handed out on this thread, so the chunks are marked
+    // dirty here; each is meshed once after relighting.
+    for (const ChunkCoord& coords : pendingTerrain) {
+        findChunk(coords)->markDirty();
+        seedChunkLight(coords);
+        remeshNeighbors(coords);
+    }
+    pendingTerrain.clear();
 }
 
-bool ChunkManager::isChunkLoaded(int chunkX, int chunkZ) const {
+ChunkManager::ChunkColumn& ChunkManager::loadColumnData(int chunkX, int chunkZ) {
     std::pair<int, int> key = std::make_pair(chunkX, chunkZ);
-    return chunks.find(key) != chunks.end();
+    auto it = columns.find(key);
+    if (it == columns.end()) {
+        it = insertReusingNode(columns, spareColumnNodes, key);
+        generateColumn(chunkX, chunkZ, it->second);
+    }
+    return it->second;
 }
 
-std::shared_ptr<Chunk> ChunkManager::getChunk(int chunkX, int chunkZ) const {
+void ChunkManager::loadColumn(int chunkX, int chunkZ) {
+    updateColumnChunks(chunkX, chunkZ, loadColumnData(chunkX, chunkZ));
+}
+
+void ChunkManager::unloadColumn(int chunkX, int chunkZ) {
     std::pair<int, int> key = std::make_pair(chunkX, chunkZ);
-    auto it = chunks.find(key);
-    if (it != chunks.end()) {
-        return it->second;
+    auto it = columns.find(key);
+    if (it == columns.end()) {
+        return;
+    }
+    for (int chunkY = it->second.minLoadedY; chunkY <= it->second.maxLoadedY; chunkY++) {
+        unloadChunk(chunkX, chunkY, chunkZ);
+    }
+    spareColumnNodes.push_back(columns.extract(it));
+    
+    auto prefetched = std::find(prefetchedColumns.begin(), prefetchedColumns.end(), key);
+    if (prefetched != prefetchedColumns.end()) {
+        streamingStats.prefetchWasted++;
+        *prefetched = prefetchedColumns.back();
+        prefetchedColumns.pop_back();
     }
-    return nullptr;
+}
+
+void ChunkManager::updateColumnChunks(int chunkX, int chunkZ, ChunkColumn& column) {
+    // The column keeps the chunks holding its terrain, and those within the
+    // vertical view distance of the camera's chunk. Those loaded ahead of
+    // the band stay while it may still reach them.
+    const int surfaceMinY = floorDiv(column.minSurfaceY, Chunk::CHUNK_SIZE_Y);
+    const int surfaceMaxY = floorDiv(column.maxContentY, Chunk::CHUNK_SIZE_Y);
+    const int bandMinY = centerChunkY - verticalViewDistance;
+    const int bandMaxY = centerChunkY + verticalViewDistance;
+    
+    int keptMinY = std::min(surfaceMinY, bandMinY);
+    int keptMaxY = std::max(surfaceMaxY, bandMaxY);
+    for (int chunkY = column.minLoadedY; chunkY <= column.maxLoadedY; chunkY++) {
+        bool needed = (chunkY >= surfaceMinY && chunkY <= surfaceMaxY) || (chunkY >= bandMinY && chunkY <= bandMaxY);
+        if (needed) {
+            continue;
+        }
+        if (chunkY >= prefetchMinY && chunkY <= prefetchMaxY &&
+            chunks.find(ChunkCoord(chunkX, chunkY, chunkZ)) != chunks.end()) {
+            keptMinY = std::min(keptMinY, chunkY);
+            keptMaxY = std::max(keptMaxY, chunkY);
+            continue;
+        }
+        unloadChunk(chunkX, chunkY, chunkZ);
+    }
+    column.minLoadedY = keptMinY;
+    column.maxLoadedY = keptMaxY;
+    column.bandCenterY = centerChunkY;
+    
+    for (int chunkY = surfaceMinY; chunkY <= surfaceMaxY; chunkY++) {
+        beginLoadChunk(chunkX, chunkY, chunkZ);
+    }
+    for (int chunkY = bandMinY; chunkY <= bandMaxY; chunkY++) {
+        beginLoadChunk(chunkX, chunkY, chunkZ);
+    }
+}
+
+void ChunkManager::remeshNeighbors(const ChunkCoord& coords) {
+    // Full-resolution meshes leave out the border faces their neighbours
+    // hide, so a neighbour coming or going changes them. Reduced meshes
+    // only build against neighbours already drawn at their level (see
+    // remeshReducedNeighbors).
+    for (const ChunkCoord& step : SIDE_STEPS) {
+        Chunk* neighbor = findChunk(coords + step);
+        if (neighbor && neighbor->getActiveLod() == 0 && !neighbor->needsRemesh(0)) {
+            neighbor->markDirty();
+        }
+    }
+}
+
+void ChunkManager::remeshReducedNeighbors(const ChunkCoord& coords, NeighborChange change) {
+    // Reduced meshes leave out the border faces a neighbour drawn at the
+    // same level hides. Called when the chunk at coords changed its blocks
+    // or level, or was loaded or unloaded: neighbours that culled against
+    // it are rebuilt where its blocks changed or it is no longer drawn at
+    // their level. Neighbours that could now cull against it keep their
+    // extra faces, which it covers, until they are rebuilt anyway. Builds
+    // in flight are checked when they are applied.
+    const ChunkCoord cameraChunk(centerChunkX, centerChunkY, centerChunkZ);
+    for (int side = 0; side < 6; side++) {
+        const ChunkCoord& step = SIDE_STEPS[side];
+        Chunk* neighbor = findChunk(coords + step);
+        if (!neighbor || neighbor->getActiveLod() == 0) {
+            continue;
+        }
+        // Opposite sides are adjacent in BlockFace order
+        const Chunk::Mesh& mesh = neighbor->getMesh();
+        unsigned int facing = 1u << (side ^ 1);
+        if (!(mesh.sharedSides & facing)) {
+            continue;
+        }
+        // Chunks are unloaded from the edges of the loaded area, so the
+        // faces left uncovered mostly look away from the camera, as when
+        // the band moves up or down. Those stay culled until the chunk is
+        // loaded again, which rebuilds them.
+        ChunkCoord toCamera = cameraChunk - coords;
+        if (change == NeighborChange::Unload && toCamera.x * step.x + toCamera.y * step.y + toCamera.z * step.z > 0) {
+            continue;
+        }
+        if (change != NeighborChange::Level || !isDrawnAtLevel(coords, neighbor->getActiveLod())) {
+            neighbor->markDirty();
+        }
+    }
+}
+
+bool ChunkManager::isDrawnAtLevel(const ChunkCoord& coords, int level) const {
+    // Chunks not meshed yet count at the level they are about to be drawn at
+    const Chunk* chunk = findChunk(coords);
+    if (!chunk) {
+        return false;
+    }
+    return chunk->hasMesh() ? chunk->getActiveLod() == level : getLodForDistance(getChunkDistance(coords)) == level;
+}
+
+unsigned int ChunkManager::getSharedSides(const ChunkCoord& coords, int level) const {
+    // Sides whose neighbour is drawn at this reduced level, so the faces
+    // between the two can be left out
+    unsigned int sides = 0;
+    for (int side = 0; side < 6; side++) {
+        if (isDrawnAtLevel(coords + SIDE_STEPS[side], level)) {
+            sides |= 1u << side;
+        }
+    }
+    return sides;
+}
+
+Chunk* ChunkManager::materializeChunk(const ChunkCoord& coords) {
+    auto entry = chunks.find(coords);
+    auto column = columns.find(std::make_pair(coords.x, coords.z));
+    if (entry == chunks.end() || column == columns.end()) {
+        return nullptr;
+    }
+    if (entry->second) {
+        return entry->second;
+    }
+    
+    Chunk* chunk = chunkPool.acquire(coords.x, coords.y, coords.z);
+    if (!chunk) {
+        std::cerr << "Error: chunk pool of " << chunkPool.getCapacity() << " chunks is full, cannot store chunk ("
+                  << coords.x << ", " << coords.y << ", " << coords.z << ")" << std::endl;
+        return nullptr;
+    }
+    entry->second = chunk;
+    
+    // The column now holds blocks or light up to here, so the chunk stays
+    // loaded with its terrain and is no longer taken for open air
+    column->second.maxContentY = std::max(column->second.maxContentY, (coords.y + 1) * Chunk::CHUNK_SIZE_Y - 1);
+    seedChunkLight(coords);
+    return chunk;
+}
+
+bool ChunkManager::isChunkLoaded(int chunkX, int chunkY, int chunkZ) const {
+    return chunks.find(ChunkCoord(chunkX, chunkY, chunkZ)) != chunks.end();
+}
+
+bool ChunkManager::isColumnLoaded(int chunkX, int chunkZ) const {
+    return columns.find(std::make_pair(chunkX, chunkZ)) != columns.end();
+}
+
+Chunk* ChunkManager::getChunk(int chunkX, int chunkY, int chunkZ) const {
+    return findChunk(ChunkCoord(chunkX, chunkY, chunkZ));
+}
+
+bool ChunkManager::getSurfaceHeight(int voxelX, int voxelZ, int& height) const {
+    int chunkX = floorDiv(voxelX, Chunk::CHUNK_SIZE_X);
+    int chunkZ = floorDiv(voxelZ, Chunk::CHUNK_SIZE_Z);
+    auto it = columns.find(std::make_pair(chunkX, chunkZ));
+    if (it == columns.end()) {
+        return false;
+    }
+    height = it->second.heightMap[(voxelX - chunkX * Chunk::CHUNK_SIZE_X) +
+                                  (voxelZ - chunkZ * Chunk::CHUNK_SIZE_Z) * Chunk::CHUNK_SIZE_X];
+    return true;
+}
+
+Chunk::SnapshotPtr ChunkManager::getChunkSnapshot(int chunkX, int chunkY, int chunkZ) {
+    Chunk* chunk = findChunk(ChunkCoord(chunkX, chunkY, chunkZ));
+    return chunk ? snapshotPool->capture(*chunk) : nullptr;
+}
+
+ChunkSnapshotView ChunkManager::getSnapshotView(int chunkX, int chunkY, int chunkZ) {
+    ChunkSnapshotView view;
+    view.center = getChunkSnapshot(chunkX, chunkY, chunkZ);
+    if (view.center) {
+        view.neighbors[0] = getChunkSnapshot(chunkX - 1, chunkY, chunkZ);
+        view.neighbors[1] = getChunkSnapshot(chunkX + 1, chunkY, chunkZ);
+        view.neighbors[2] = getChunkSnapshot(chunkX, chunkY, chunkZ - 1);
+        view.neighbors[3] = getChunkSnapshot(chunkX, chunkY, chunkZ + 1);
+        view.neighbors[4] = getChunkSnapshot(chunkX, chunkY - 1, chunkZ);
+        view.neighbors[5] = getChunkSnapshot(chunkX, chunkY + 1, chunkZ);
+    }
+    return view;
+}
+
+bool ChunkManager::isSnapshotCurrent(const Chunk::VoxelSnapshot& snapshot) const {
+    // Versions are unique across chunks, so a chunk loaded in the place of
+    // the one the snapshot came from never matches
+    const Chunk* chunk = findChunk(ChunkCoord(snapshot.chunkX, snapshot.chunkY, snapshot.chunkZ));
+    return chunk && chunk->getVersion() == snapshot.version;
+}
+
+void ChunkManager::getChunkWorldBounds(int chunkX, int chunkY, int chunkZ, glm::vec3& minCorner, glm::vec3& maxCorner) const {
+    // Voxel positions are cube centres, so the cubes reach half a voxel past them
+    float halfVoxel = voxelScale * 0.5f;
+    minCorner = glm::vec3(chunkX * Chunk::CHUNK_SIZE_X * voxelScale - halfVoxel,
+                          chunkY * Chunk::CHUNK_SIZE_Y * voxelScale - halfVoxel,
+                          chunkZ * Chunk::CHUNK_SIZE_Z * voxelScale - halfVoxel);
+    maxCorner = minCorner + glm::vec3(Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y, Chunk::CHUNK_SIZE_Z) * voxelScale;
 }
 
 void ChunkManager::worldToChunkCoords(const glm::vec3& worldPos, int& chunkX, int& chunkZ) const {
@@ -56,10 +438,15 @@ void ChunkManager::worldToChunkCoords(const glm::vec3& worldPos, int& chunkX, in
     chunkZ = static_cast<int>(std::floor(voxelZ / Chunk::CHUNK_SIZE_Z));
 }
 
-std::shared_ptr<Chunk> ChunkManager::getChunkAtPosition(const glm::vec3& worldPos) const {
-    int chunkX, chunkZ;
+void ChunkManager::worldToChunkCoords(const glm::vec3& worldPos, int& chunkX, int& chunkY, int& chunkZ) const {
     worldToChunkCoords(worldPos, chunkX, chunkZ);
-    return getChunk(chunkX, chunkZ);
+    chunkY = static_cast<int>(std::floor(worldPos.y / voxelScale / Chunk::CHUNK_SIZE_Y));
+}
+
+Chunk* ChunkManager::getChunkAtPosition(const glm::vec3& worldPos) const {
+    int chunkX, chunkY, chunkZ;
+    worldToChunkCoords(worldPos, chunkX, chunkY, chunkZ);
+    return getChunk(chunkX, chunkY, chunkZ);
 }
 
 unsigned int ChunkManager::getVoxelBlockId(const glm::vec3& worldPos) const {
@@ -78,7 +465,14 @@ unsigned int ChunkManager::getVoxelBlockId(const glm::vec3& worldPos) const {
 }
 
 void ChunkManager::setVoxel(const glm::vec3& worldPos, unsigned int blockId) {
-    auto chunk = getChunkAtPosition(worldPos);
+    int chunkX, chunkY, chunkZ;
+    worldToChunkCoords(worldPos, chunkX, chunkY, chunkZ);
+    Chunk* chunk = getChunk(chunkX, chunkY, chunkZ);
+    
+    // A chunk of only air gets storage when a block is put in it
+    if (!chunk && blockId != 0) {
+        chunk = materializeChunk(ChunkCoord(chunkX, chunkY, chunkZ));
+    }
     if (!chunk) {
         return;
     }
@@ -86,114 +480,1080 @@ void ChunkManager::setVoxel(const glm::vec3& worldPos, unsigned int blockId) {
     // Convert world position to local chunk coordinates
     int localX, localY, localZ;
     if (chunk->toLocalPosition(worldPos, localX, localY, localZ)) {
-        chunk->setVoxel(localX, localY, localZ, blockId);
-        
-        // Mark neighboring chunks as dirty if the voxel is on the edge
-        if (localX == 0) {
-            auto neighborChunk = getChunk(chunk->getChunkX() - 1, chunk->getChunkZ());
-            if (neighborChunk) {
-                neighborChunk->markDirty();
+        ChunkEdit edit;
+        editVoxel(*chunk, localX, localY, localZ, blockId, edit);
+        finishChunkEdit(*chunk, edit);
+        finishBulkEdit();
+    }
+}
+
+bool ChunkManager::isVoxelSolid(const glm::vec3& worldPos) const {
+    return BlockDatabase::getInstance().isSolid(getVoxelBlockId(worldPos));
+}
+
+size_t ChunkManager::fillBox(const glm::ivec3& minVoxel, const glm::ivec3& maxVoxel, unsigned int blockId) {
+    PROFILE_FUNCTION();
+    
+    return fillRows(minVoxel, maxVoxel, blockId, [&](int, int, int& minX, int& maxX) {
+        minX = minVoxel.x;
+        maxX = maxVoxel.x;
+        return true;
+    });
+}
+
+size_t ChunkManager::fillSphere(const glm::ivec3& center, int radius, unsigned int blockId) {
+    PROFILE_FUNCTION();
+    
+    if (radius < 0) {
+        return 0;
+    }
+    
+    // Each row through the sphere is a span of whole voxels around center.x
+    return fillRows(center - glm::ivec3(radius), center + glm::ivec3(radius), blockId,
+        [&](int voxelY, int voxelZ, int& minX, int& maxX) {
+            int dy = voxelY - center.y;
+            int dz = voxelZ - center.z;
+            int remaining = radius * radius - dy * dy - dz * dz;
+            if (remaining < 0) {
+                return false;
             }
-        }
-        else if (localX == Chunk::CHUNK_SIZE_X - 1) {
-            auto neighborChunk = getChunk(chunk->getChunkX() + 1, chunk->getChunkZ());
-            if (neighborChunk) {
-                neighborChunk->markDirty();
+            int halfWidth = static_cast<int>(std::sqrt(static_cast<double>(remaining)));
+            while ((halfWidth + 1) * (halfWidth + 1) <= remaining) {
+                halfWidth++;
             }
+            while (halfWidth * halfWidth > remaining) {
+                halfWidth--;
+            }
+            minX = center.x - halfWidth;
+            maxX = center.x + halfWidth;
+            return true;
+        });
+}
+
+size_t ChunkManager::applyEdits(const std::vector<VoxelEdit>& edits) {
+    PROFILE_FUNCTION();
+    
+    // Group the edits by chunk, so each chunk is looked up once. Ties are
+    // kept in list order, so later writes to a voxel still land last. The
+    // key takes 21 bits of each chunk coordinate.
+    const uint64_t KEY_MASK = (uint64_t(1) << 21) - 1;
+    editOrder.resize(edits.size());
+    for (size_t i = 0; i < edits.size(); i++) {
+        uint64_t chunkX = static_cast<uint32_t>(floorDiv(edits[i].voxel.x, Chunk::CHUNK_SIZE_X)) & KEY_MASK;
+        uint64_t chunkY = static_cast<uint32_t>(floorDiv(edits[i].voxel.y, Chunk::CHUNK_SIZE_Y)) & KEY_MASK;
+        uint64_t chunkZ = static_cast<uint32_t>(floorDiv(edits[i].voxel.z, Chunk::CHUNK_SIZE_Z)) & KEY_MASK;
+        editOrder[i] = std::make_pair((chunkX << 42) | (chunkY << 21) | chunkZ, static_cast<uint32_t>(i));
+    }
+    std::sort(editOrder.begin(), editOrder.end());
+    
+    size_t changed = 0;
+    size_t runStart = 0;
+    while (runStart < editOrder.size()) {
+        uint64_t key = editOrder[runStart].first;
+        size_t runEnd = runStart + 1;
+        while (runEnd < editOrder.size() && editOrder[runEnd].first == key) {
+            runEnd++;
         }
         
-        if (localZ == 0) {
-            auto neighborChunk = getChunk(chunk->getChunkX(), chunk->getChunkZ() - 1);
-            if (neighborChunk) {
-                neighborChunk->markDirty();
+        const glm::ivec3& first = edits[editOrder[runStart].second].voxel;
+        ChunkCoord coords(floorDiv(first.x, Chunk::CHUNK_SIZE_X), floorDiv(first.y, Chunk::CHUNK_SIZE_Y),
+                          floorDiv(first.z, Chunk::CHUNK_SIZE_Z));
+        glm::ivec3 base = coords * glm::ivec3(Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y, Chunk::CHUNK_SIZE_Z);
+        Chunk* chunk = findChunk(coords);
+        
+        // A chunk of only air gets storage if any of its edits puts a block in it
+        if (!chunk && std::any_of(editOrder.begin() + runStart, editOrder.begin() + runEnd,
+                                  [&](const std::pair<uint64_t, uint32_t>& entry) { return edits[entry.second].blockId != 0; })) {
+            chunk = materializeChunk(coords);
+        }
+        if (chunk) {
+            ChunkEdit edit;
+            for (size_t i = runStart; i < runEnd; i++) {
+                const VoxelEdit& voxelEdit = edits[editOrder[i].second];
+                glm::ivec3 local = voxelEdit.voxel - base;
+                
+                // Chunks a multiple of 2^21 apart share a key
+                if (chunk->isValidLocalPosition(local.x, local.y, local.z)) {
+                    editVoxel(*chunk, local.x, local.y, local.z, voxelEdit.blockId, edit);
+                }
             }
+            finishChunkEdit(*chunk, edit);
+            changed += edit.voxelsChanged;
         }
-        else if (localZ == Chunk::CHUNK_SIZE_Z - 1) {
-            auto neighborChunk = getChunk(chunk->getChunkX(), chunk->getChunkZ() + 1);
-            if (neighborChunk) {
-                neighborChunk->markDirty();
+        runStart = runEnd;
+    }
+    
+    finishBulkEdit();
+    return changed;
+}
+
+size_t ChunkManager::fillRows(const glm::ivec3& minVoxel, const glm::ivec3& maxVoxel, unsigned int blockId,
+                              const std::function<bool(int voxelY, int voxelZ, int& minX, int& maxX)>& rowSpan) {
+    // Visit the chunks overlapping the box, then the box's rows inside each,
+    // with x innermost to walk block storage in order
+    size_t changed = 0;
+    for (int chunkZ = floorDiv(minVoxel.z, Chunk::CHUNK_SIZE_Z); chunkZ <= floorDiv(maxVoxel.z, Chunk::CHUNK_SIZE_Z); chunkZ++) {
+        for (int chunkY = floorDiv(minVoxel.y, Chunk::CHUNK_SIZE_Y); chunkY <= floorDiv(maxVoxel.y, Chunk::CHUNK_SIZE_Y); chunkY++) {
+            for (int chunkX = floorDiv(minVoxel.x, Chunk::CHUNK_SIZE_X); chunkX <= floorDiv(maxVoxel.x, Chunk::CHUNK_SIZE_X); chunkX++) {
+                ChunkCoord coords(chunkX, chunkY, chunkZ);
+                auto entry = chunks.find(coords);
+                if (entry == chunks.end() || (!entry->second && blockId == 0)) {
+                    continue;
+                }
+                Chunk* chunk = entry->second;
+                
+                int baseX = chunkX * Chunk::CHUNK_SIZE_X;
+                int baseY = chunkY * Chunk::CHUNK_SIZE_Y;
+                int baseZ = chunkZ * Chunk::CHUNK_SIZE_Z;
+                int minY = std::max(minVoxel.y, baseY);
+                int maxY = std::min(maxVoxel.y, baseY + Chunk::CHUNK_SIZE_Y - 1);
+                int minZ = std::max(minVoxel.z, baseZ);
+                int maxZ = std::min(maxVoxel.z, baseZ + Chunk::CHUNK_SIZE_Z - 1);
+                ChunkEdit edit;
+                bool writable = true;
+                for (int z = minZ; z <= maxZ && writable; z++) {
+                    for (int y = minY; y <= maxY; y++) {
+                        int minX, maxX;
+                        if (!rowSpan(y, z, minX, maxX)) {
+                            continue;
+                        }
+                        minX = std::max(minX, baseX);
+                        maxX = std::min(maxX, baseX + Chunk::CHUNK_SIZE_X - 1);
+                        if (minX > maxX) {
+                            continue;
+                        }
+                        
+                        // A chunk of only air gets storage once a row puts blocks in it
+                        if (!chunk && !(chunk = materializeChunk(coords))) {
+                            writable = false;
+                            break;
+                        }
+                        for (int x = minX; x <= maxX; x++) {
+                            editVoxel(*chunk, x - baseX, y - baseY, z - baseZ, blockId, edit);
+                        }
+                    }
+                }
+                if (chunk) {
+                    finishChunkEdit(*chunk, edit);
+                    changed += edit.voxelsChanged;
+                }
             }
         }
     }
+    
+    finishBulkEdit();
+    return changed;
 }
 
-bool ChunkManager::isVoxelSolid(const glm::vec3& worldPos) const {
-    unsigned int blockId = getVoxelBlockId(worldPos);
-    return blockId != 0 && blockId != 7; // Air and water are not solid
+void ChunkManager::editVoxel(Chunk& chunk, int localX, int localY, int localZ, unsigned int blockId, ChunkEdit& edit) {
+    if (chunk.exchangeVoxel(localX, localY, localZ, blockId) == blockId) {
+        return;
+    }
+    edit.voxelsChanged++;
+    edit.borders[static_cast<int>(BlockFace::TOP)] |= localY == Chunk::CHUNK_SIZE_Y - 1;
+    edit.borders[static_cast<int>(BlockFace::BOTTOM)] |= localY == 0;
+    edit.borders[static_cast<int>(BlockFace::FRONT)] |= localZ == Chunk::CHUNK_SIZE_Z - 1;
+    edit.borders[static_cast<int>(BlockFace::BACK)] |= localZ == 0;
+    edit.borders[static_cast<int>(BlockFace::LEFT)] |= localX == 0;
+    edit.borders[static_cast<int>(BlockFace::RIGHT)] |= localX == Chunk::CHUNK_SIZE_X - 1;
+    
+    // Relighting is deferred to processLightUpdates so a burst of edits
+    // costs a single flood fill
+    pendingLightChanges.emplace_back(chunk.getChunkX() * Chunk::CHUNK_SIZE_X + localX,
+                                     chunk.getChunkY() * Chunk::CHUNK_SIZE_Y + localY,
+                                     chunk.getChunkZ() * Chunk::CHUNK_SIZE_Z + localZ);
 }
 
-void ChunkManager::updateChunks(const glm::vec3& cameraPos) {
+void ChunkManager::finishChunkEdit(const Chunk& chunk, const ChunkEdit& edit) {
+    if (edit.voxelsChanged == 0) {
+        return;
+    }
+    
+    // Neighbours sharing a changed border voxel may show or hide a face there
+    ChunkCoord coords = chunk.getCoords();
+    markChunkChanged(editedChunks, coords);
+    for (int side = 0; side < 6; side++) {
+        if (edit.borders[side]) {
+            markChunkChanged(editedChunks, coords + SIDE_STEPS[side]);
+        }
+    }
+}
+
+void ChunkManager::finishBulkEdit() {
+    // A reduced cell reaches further into the chunk than one voxel, so
+    // reduced neighbours are rebuilt whatever voxels changed, and builds in
+    // flight that saw the old blocks are dropped
+    for (const ChunkCoord& coords : editedChunks) {
+        remeshReducedNeighbors(coords, NeighborChange::Blocks);
+        for (const ChunkCoord& step : SIDE_STEPS) {
+            if (isLodBuildInFlight(coords + step)) {
+                findChunk(coords + step)->markDirty();
+            }
+        }
+    }
+    markChunksDirty(editedChunks);
+}
+
+void ChunkManager::markChunkChanged(DirtyChunkSet& dirtyChunks, const ChunkCoord& coords) {
+    if (dirtyChunks.find(coords) != dirtyChunks.end()) {
+        return;
+    }
+    if (spareDirtyNodes.empty()) {
+        dirtyChunks.insert(coords);
+        return;
+    }
+    DirtyChunkSet::node_type node = std::move(spareDirtyNodes.back());
+    spareDirtyNodes.pop_back();
+    node.value() = coords;
+    dirtyChunks.insert(std::move(node));
+}
+
+void ChunkManager::markChunksDirty(DirtyChunkSet& dirtyChunks) {
+    // Each chunk once, however many of its voxels changed
+    for (const ChunkCoord& coords : dirtyChunks) {
+        Chunk* chunk = findChunk(coords);
+        if (chunk) {
+            chunk->markDirty();
+        }
+    }
+    while (!dirtyChunks.empty()) {
+        spareDirtyNodes.push_back(dirtyChunks.extract(dirtyChunks.begin()));
+    }
+}
+
+void ChunkManager::updateChunks(const glm::vec3& cameraPos, const glm::vec3& velocity, const glm::vec3& viewDirection) {
+    PROFILE_FUNCTION();
+    
+    changedChunks.clear();
+    
     // Convert camera position to chunk coordinates
-    int centerChunkX, centerChunkZ;
-    worldToChunkCoords(cameraPos, centerChunkX, centerChunkZ);
+    worldToChunkCoords(cameraPos, centerChunkX, centerChunkY, centerChunkZ);
     
-    // Determine the range of chunks to load
+    // Fit the view to the memory budget. The columns a shrink leaves outside
+    // it are the farthest, and are unloaded below.
+    bool viewShrank = false;
+    if (residencyGovernor.update(columns.size())) {
+        viewShrank = residencyGovernor.getViewDistance() < viewDistanceInChunks;
+        viewDistanceInChunks = residencyGovernor.getViewDistance();
+    }
+    
+    // Determine the range of columns to load
     int minChunkX = centerChunkX - viewDistanceInChunks;
     int maxChunkX = centerChunkX + viewDistanceInChunks;
     int minChunkZ = centerChunkZ - viewDistanceInChunks;
     int maxChunkZ = centerChunkZ + viewDistanceInChunks;
     
-    // Load chunks in range
+    findPrefetchCandidates(cameraPos, velocity, viewDirection);
+    
+    // Prefetched columns now in view were ready in time. The load latency
+    // of their chunks counts from here, when they are first needed.
+    for (size_t i = 0; i < prefetchedColumns.size();) {
+        const std::pair<int, int>& key = prefetchedColumns[i];
+        if (!isInViewArea(key.first, key.second)) {
+            i++;
+            continue;
+        }
+        streamingStats.prefetchHits++;
+        auto column = columns.find(key);
+        if (column != columns.end()) {
+            for (int chunkY = column->second.minLoadedY; chunkY <= column->second.maxLoadedY; chunkY++) {
+                auto pending = pendingLoadStartNs.find(ChunkCoord(key.first, chunkY, key.second));
+                if (pending != pendingLoadStartNs.end()) {
+                    pending->second = steadyNowNs();
+                }
+            }
+        }
+        prefetchedColumns[i] = prefetchedColumns.back();
+        prefetchedColumns.pop_back();
+    }
+    
+    // Likewise for chunks loaded ahead of the band. Those the band will no
+    // longer reach, or whose column left the view area, were wasted.
+    for (size_t i = 0; i < prefetchedChunks.size();) {
+        const ChunkCoord coords = prefetchedChunks[i];
+        bool inView = isInViewArea(coords.x, coords.z);
+        bool inBand = std::abs(coords.y - centerChunkY) <= verticalViewDistance;
+        if (inView && !inBand && coords.y >= prefetchMinY && coords.y <= prefetchMaxY) {
+            i++;
+            continue;
+        }
+        if (inView && inBand) {
+            streamingStats.prefetchHits++;
+            auto pending = pendingLoadStartNs.find(coords);
+            if (pending != pendingLoadStartNs.end()) {
+                pending->second = steadyNowNs();
+            }
+        } else {
+            streamingStats.prefetchWasted++;
+            if (inView) {
+                unloadChunk(coords.x, coords.y, coords.z);
+            }
+        }
+        prefetchedChunks[i] = prefetchedChunks.back();
+        prefetchedChunks.pop_back();
+    }
+    
+    // Unload columns outside of view distance first, so their pool slots
+    // are free for the chunks coming into view. Columns still on the
+    // predicted path stay.
+    columnsToUnload.clear();
+    for (const auto& [coords, column] : columns) {
+        if (!isInViewArea(coords.first, coords.second) &&
+            std::find(prefetchCandidates.begin(), prefetchCandidates.end(), coords) == prefetchCandidates.end()) {
+            columnsToUnload.push_back(coords);
+        }
+    }
+    
+    for (const auto& coords : columnsToUnload) {
+        unloadColumn(coords.first, coords.second);
+    }
+    
+    // Fewer chunks will be loaded from now on, so give the evicted ones'
+    // memory back instead of keeping it for reuse
+    if (viewShrank) {
+        chunkPool.trim();
+        Chunk::releaseSpareFaceBuffers();
+        spareChunkNodes.clear();
+        spareColumnNodes.clear();
+        spareLoadStartNodes.clear();
+    }
+    
+    // Load columns in range, and move the chunks loaded in the others along
+    // with the camera's height
     for (int x = minChunkX; x <= maxChunkX; x++) {
         for (int z = minChunkZ; z <= maxChunkZ; z++) {
-            if (!isChunkLoaded(x, z)) {
-                loadChunk(x, z);
+            auto column = columns.find(std::make_pair(x, z));
+            if (column == columns.end()) {
+                if (viewAreaLoaded) {
+                    streamingStats.prefetchMisses++;
+                }
+                loadColumn(x, z);
+            } else if (column->second.bandCenterY != centerChunkY) {
+                // Chunks of the band with storage that were not loaded ahead
+                for (int chunkY = centerChunkY - verticalViewDistance; chunkY <= centerChunkY + verticalViewDistance; chunkY++) {
+                    if (chunkY * Chunk::CHUNK_SIZE_Y <= column->second.maxContentY &&
+                        chunks.find(ChunkCoord(x, chunkY, z)) == chunks.end()) {
+                        streamingStats.prefetchMisses++;
+                    }
+                }
+                updateColumnChunks(x, z, column->second);
             }
         }
     }
+    viewAreaLoaded = true;
     
-    // Unload chunks outside of view distance
-    std::vector<std::pair<int, int>> chunksToUnload;
+    // Then, as far as the budget goes, the columns and chunks ahead
+    prefetchChunks();
     
-    for (const auto& [coords, chunk] : chunks) {
-        int chunkX = coords.first;
-        int chunkZ = coords.second;
+    // Generate the chunks loaded above, all at once on the workers
+    generatePendingTerrain();
+    
+    // Relight edited and newly loaded chunks before remeshing them
+    processLightUpdates();
+    
+    // Update meshes for dirty chunks
+    updateChunkMeshes();
+}
+
+void ChunkManager::findPrefetchCandidates(const glm::vec3& cameraPos, const glm::vec3& velocity,
+                                          const glm::vec3& viewDirection) {
+    PROFILE_FUNCTION();
+    
+    prefetchCandidates.clear();
+    prefetchMinY = centerChunkY - verticalViewDistance;
+    prefetchMaxY = centerChunkY + verticalViewDistance;
+    
+    // Over the memory budget, chunks ahead are the first to go
+    if (!config.prefetch.enabled || residencyGovernor.isOverBudget()) {
+        return;
+    }
+    
+    // Climbing or falling moves the band of chunks loaded around the
+    // camera's height; extrapolate where it will be
+    if (std::abs(velocity.y) >= MIN_PREFETCH_SPEED) {
+        glm::vec3 ahead = cameraPos + glm::vec3(0.0f, velocity.y * config.prefetch.lookAheadSeconds, 0.0f);
+        int aheadX, aheadY, aheadZ;
+        worldToChunkCoords(ahead, aheadX, aheadY, aheadZ);
+        prefetchMinY = std::min(prefetchMinY, aheadY - verticalViewDistance);
+        prefetchMaxY = std::max(prefetchMaxY, aheadY + verticalViewDistance);
+    }
+    
+    // Horizontal movement brings new columns
+    glm::vec2 motion(velocity.x, velocity.z);
+    float speed = glm::length(motion);
+    if (speed < MIN_PREFETCH_SPEED) {
+        return;
+    }
+    
+    // Extrapolate between the direction of movement and the view direction,
+    // which is where the camera tends to turn
+    glm::vec2 heading = motion / speed;
+    glm::vec2 view(viewDirection.x, viewDirection.z);
+    if (glm::length(view) > 1e-3f) {
+        glm::vec2 blended = heading + glm::normalize(view);
+        if (glm::length(blended) > 1e-3f) {
+            heading = glm::normalize(blended);
+        }
+    }
+    
+    // Walk the path in half-chunk steps. At each point the camera would need
+    // the view area around it, widened by the cone for the turns it may take
+    // by then; the columns of that area not in the current view area, nor in
+    // the previous point's, are the next candidates.
+    const float chunkWidth = Chunk::CHUNK_SIZE_X * voxelScale;
+    const float stepLength = 0.5f * chunkWidth;
+    const float pathLength = speed * config.prefetch.lookAheadSeconds;
+    const float spread = std::tan(glm::radians(config.prefetch.coneAngle));
+    const size_t maxCandidates = static_cast<size_t>(std::max(0, config.prefetch.maxChunks));
+    const int stepCount = static_cast<int>(std::ceil(pathLength / stepLength));
+    
+    int previousX = centerChunkX;
+    int previousZ = centerChunkZ;
+    int previousRadius = viewDistanceInChunks;
+    for (int step = 1; step <= stepCount; step++) {
+        float distance = std::min(step * stepLength, pathLength);
+        glm::vec3 point = cameraPos + glm::vec3(heading.x, 0.0f, heading.y) * distance;
+        int pointX, pointZ;
+        worldToChunkCoords(point, pointX, pointZ);
+        int radius = viewDistanceInChunks + static_cast<int>(distance * spread / chunkWidth);
+        if (pointX == previousX && pointZ == previousZ && radius == previousRadius) {
+            continue;
+        }
         
-        if (chunkX < minChunkX || chunkX > maxChunkX || chunkZ < minChunkZ || chunkZ > maxChunkZ) {
-            chunksToUnload.push_back(coords);
+        for (int x = pointX - radius; x <= pointX + radius; x++) {
+            for (int z = pointZ - radius; z <= pointZ + radius; z++) {
+                std::pair<int, int> coords(x, z);
+                if (isInViewArea(x, z) ||
+                    std::max(std::abs(x - previousX), std::abs(z - previousZ)) <= previousRadius ||
+                    std::find(prefetchCandidates.begin(), prefetchCandidates.end(), coords) != prefetchCandidates.end()) {
+                    continue;
+                }
+                prefetchCandidates.push_back(coords);
+                if (prefetchCandidates.size() >= maxCandidates) {
+                    return;
+                }
+            }
         }
+        previousX = pointX;
+        previousZ = pointZ;
+        previousRadius = radius;
     }
+}
+
+void ChunkManager::prefetchChunks() {
+    PROFILE_FUNCTION();
     
-    for (const auto& coords : chunksToUnload) {
-        unloadChunk(coords.first, coords.second);
+    int budget = config.prefetch.chunksPerUpdate;
+    for (const auto& coords : prefetchCandidates) {
+        if (budget <= 0) {
+            return;
+        }
+        if (chunkPool.getUsedCount() >= chunkPool.getCapacity()) {
+            return;  // The pool is full
+        }
+        if (isColumnLoaded(coords.first, coords.second)) {
+            continue;
+        }
+        loadColumn(coords.first, coords.second);
+        prefetchedColumns.push_back(coords);
+        streamingStats.chunksPrefetched++;
+        budget--;
     }
     
-    // Update meshes for dirty chunks
-    updateChunkMeshes();
+    // Then the chunks the band will reach, the rows next to it first and in
+    // each row the columns nearest the camera first. Air above the terrain
+    // takes no storage and is loaded for free.
+    const size_t maxChunks = static_cast<size_t>(std::max(0, config.prefetch.maxChunks));
+    const int bandMinY = centerChunkY - verticalViewDistance;
+    const int bandMaxY = centerChunkY + verticalViewDistance;
+    const int rowCount = std::max(bandMinY - prefetchMinY, prefetchMaxY - bandMaxY);
+    for (int row = 1; row <= rowCount; row++) {
+        for (int chunkY : {bandMaxY + row, bandMinY - row}) {
+            if (chunkY < prefetchMinY || chunkY > prefetchMaxY) {
+                continue;
+            }
+            for (int ring = 0; ring <= viewDistanceInChunks; ring++) {
+                for (int x = -ring; x <= ring; x++) {
+                    // Inner columns of the ring's square were walked by the
+                    // rings before
+                    int zStep = (std::abs(x) == ring || ring == 0) ? 1 : 2 * ring;
+                    for (int z = -ring; z <= ring; z += zStep) {
+                        if (budget <= 0 || prefetchedChunks.size() >= maxChunks ||
+                            chunkPool.getUsedCount() >= chunkPool.getCapacity()) {
+                            return;
+                        }
+                        ChunkCoord coords(centerChunkX + x, chunkY, centerChunkZ + z);
+                        if (!isColumnLoaded(coords.x, coords.z) || chunks.find(coords) != chunks.end()) {
+                            continue;
+                        }
+                        beginLoadChunk(coords.x, coords.y, coords.z);
+                        if (findChunk(coords)) {
+                            prefetchedChunks.push_back(coords);
+                            streamingStats.chunksPrefetched++;
+                            budget--;
+                        }
+                    }
+                }
+            }
+        }
+    }
 }
 
 void ChunkManager::updateChunkMeshes() {
+    PROFILE_FUNCTION();
+    
+    applyLodMeshes();
+    
+    // Near chunks are meshed here, at full resolution and against their
+    // neighbours, so edits show up in the same frame. Far chunks keep
+    // drawing their current mesh until the reduced one for their ring
+    // arrives from the workers. Prefetched chunks are not drawn, and wait to
+    // be meshed until they come into view; chunks of only air have nothing
+    // to draw.
+    lodRequests.clear();
     for (auto& [coords, chunk] : chunks) {
-        if (chunk->needsRemesh()) {
-            chunk->generateMesh();
+        if (!chunk || !isInViewArea(coords.x, coords.z)) {
+            continue;
+        }
+        int distance = getChunkDistance(coords);
+        int level = getLodForDistance(distance);
+        if (!chunk->needsRemesh(level)) {
+            continue;
+        }
+        
+        if (level == 0) {
+            Chunk::Neighbors neighbors;
+            for (int side = 0; side < 6; side++) {
+                neighbors[side] = findChunk(coords + SIDE_STEPS[side]);
+            }
+            bool levelChanged = !chunk->hasMesh() || chunk->getActiveLod() != 0;
+            uint64_t startNs = steadyNowNs();
+            size_t faceCount = chunk->generateMesh(neighbors).faces.size();
+            uint64_t endNs = steadyNowNs();
+            chunk->setActiveLod(0);
+            if (levelChanged) {
+                remeshReducedNeighbors(coords, NeighborChange::Level);
+            }
+            recordChunkMeshed(coords, faceCount, endNs - startNs, endNs);
+        } else if (!isLodBuildInFlight(coords)) {
+            lodRequests.emplace_back(distance, coords);
+        }
+    }
+    
+    requestLodMeshes(lodRequests);
+}
+
+void ChunkManager::requestLodMeshes(std::vector<std::pair<int, ChunkCoord>>& requests) {
+    PROFILE_FUNCTION();
+    
+    // Bound the snapshots held by queued builds and serve the nearest chunks first
+    const size_t maxInFlight = workerPool.getThreadCount() * 4;
+    if (lodBuildsInFlight.size() >= maxInFlight) {
+        return;
+    }
+    size_t count = std::min(requests.size(), maxInFlight - lodBuildsInFlight.size());
+    std::partial_sort(requests.begin(), requests.begin() + count, requests.end(),
+                      [](const std::pair<int, ChunkCoord>& a, const std::pair<int, ChunkCoord>& b) { return a.first < b.first; });
+    
+    // Queue the farthest first: workers take jobs from the back
+    for (size_t i = count; i-- > 0;) {
+        const ChunkCoord& coords = requests[i].second;
+        LodMeshJob job{getLodForDistance(requests[i].first), snapshotPool->capture(*findChunk(coords)), {}};
+        unsigned int sharedSides = getSharedSides(coords, job.level);
+        for (int side = 0; side < 6; side++) {
+            if (sharedSides & (1u << side)) {
+                job.neighbors[side] = snapshotPool->capture(*findChunk(coords + SIDE_STEPS[side]));
+            }
         }
+        {
+            std::lock_guard<std::mutex> lock(lodResultMutex);
+            lodJobs.push_back(std::move(job));
+        }
+        lodBuildsInFlight.push_back(coords);
+        workerPool.submit([this]() { buildQueuedLodMesh(); });
     }
 }
 
-std::vector<Voxel> ChunkManager::getVisibleVoxels() const {
-    std::vector<Voxel> visibleVoxels;
+void ChunkManager::buildQueuedLodMesh() {
+    // Every submitted task has a job of its own, though not necessarily the
+    // one queued with it
+    LodMeshJob job;
+    Chunk::Mesh mesh;
+    {
+        std::lock_guard<std::mutex> lock(lodResultMutex);
+        job = std::move(lodJobs.back());
+        lodJobs.pop_back();
+        if (!spareMeshes.empty()) {
+            mesh = std::move(spareMeshes.back());
+            spareMeshes.pop_back();
+        }
+    }
+    
+    Chunk::NeighborSnapshots neighbors;
+    for (int side = 0; side < 6; side++) {
+        neighbors[side] = job.neighbors[side].get();
+    }
+    uint64_t startNs = steadyNowNs();
+    Chunk::generateLodMesh(*job.snapshot, job.level, mesh, neighbors);
+    uint64_t buildNs = steadyNowNs() - startNs;
+    
+    ChunkCoord coords(job.snapshot->chunkX, job.snapshot->chunkY, job.snapshot->chunkZ);
+    uint64_t version = job.snapshot->version;
+    job.snapshot.reset();
+    for (Chunk::SnapshotPtr& neighbor : job.neighbors) {
+        neighbor.reset();
+    }
+    
+    std::lock_guard<std::mutex> lock(lodResultMutex);
+    lodResults.push_back({coords, job.level, version, std::move(mesh), buildNs});
+}
+
+bool ChunkManager::isLodBuildInFlight(const ChunkCoord& coords) const {
+    return std::find(lodBuildsInFlight.begin(), lodBuildsInFlight.end(), coords) != lodBuildsInFlight.end();
+}
+
+void ChunkManager::applyLodMeshes() {
+    PROFILE_FUNCTION();
+    
+    {
+        std::lock_guard<std::mutex> lock(lodResultMutex);
+        appliedLodResults.swap(lodResults);
+    }
+    
+    for (auto& result : appliedLodResults) {
+        auto inFlight = std::find(lodBuildsInFlight.begin(), lodBuildsInFlight.end(), result.coords);
+        if (inFlight != lodBuildsInFlight.end()) {
+            *inFlight = lodBuildsInFlight.back();
+            lodBuildsInFlight.pop_back();
+        }
+        
+        // Drop meshes of chunks that were edited, unloaded or changed ring
+        // while building, or that culled against a neighbour no longer drawn
+        // at their level; they are requested again with fresh data
+        Chunk* chunk = findChunk(result.coords);
+        if (!chunk || chunk->getVersion() != result.version ||
+            getLodForDistance(getChunkDistance(result.coords)) != result.level ||
+            (result.mesh.sharedSides & ~getSharedSides(result.coords, result.level))) {
+            continue;
+        }
+        
+        size_t faceCount = result.mesh.faces.size();
+        bool levelChanged = !chunk->hasMesh() || chunk->getActiveLod() != result.level;
+        chunk->setLodMesh(result.level, result.mesh, result.version);
+        chunk->setActiveLod(result.level);
+        if (levelChanged) {
+            remeshReducedNeighbors(result.coords, NeighborChange::Level);
+        }
+        recordChunkMeshed(result.coords, faceCount, result.buildNs, steadyNowNs());
+    }
     
+    // Hand the buffers back for the next builds: the chunks' previous
+    // meshes, or the results that were dropped
+    {
+        std::lock_guard<std::mutex> lock(lodResultMutex);
+        for (auto& result : appliedLodResults) {
+            result.mesh.clear();
+            spareMeshes.push_back(std::move(result.mesh));
+        }
+    }
+    appliedLodResults.clear();
+}
+
+void ChunkManager::resetStreamingStats() {
+    std::vector<uint64_t> loadLatencyNs = std::move(streamingStats.loadLatencyNs);
+    loadLatencyNs.clear();
+    streamingStats = ChunkStreamingStats();
+    streamingStats.loadLatencyNs = std::move(loadLatencyNs);
+}
+
+void ChunkManager::finishPendingMeshes() {
+    PROFILE_FUNCTION();
+    
+    // Applying results can request further builds (for chunks whose ring or
+    // version changed meanwhile), so repeat until nothing is outstanding
+    updateChunkMeshes();
+    while (!lodBuildsInFlight.empty()) {
+        workerPool.waitIdle();
+        updateChunkMeshes();
+    }
+}
+
+void ChunkManager::recordChunkMeshed(const ChunkCoord& coords, size_t faceCount, uint64_t buildNs, uint64_t endNs) {
+    streamingStats.meshesBuilt++;
+    streamingStats.meshedFaces += faceCount;
+    streamingStats.meshingNs += buildNs;
+    changedChunks.push_back(coords);
+    
+    // First mesh after loading: the chunk is now ready to draw
+    auto pending = pendingLoadStartNs.find(coords);
+    if (pending != pendingLoadStartNs.end()) {
+        streamingStats.loadLatencyNs.push_back(endNs - pending->second);
+        spareLoadStartNodes.push_back(pendingLoadStartNs.extract(pending));
+    }
+}
+
+const std::vector<ChunkCoord>& ChunkManager::findVisibleChunks(const glm::vec3& cameraPos) {
+    PROFILE_FUNCTION();
+    
+    visibleChunks.clear();
+    searchQueue.clear();
+    
+    // The search runs on a dense grid of the chunks within view distance of
+    // the camera's column, so each step is an index instead of a map
+    // lookup. It spans the heights of the loaded chunks, and one layer of
+    // open sky above them so the search can pass over hills.
+    int startX, startZ;
+    worldToChunkCoords(cameraPos, startX, startZ);
+    const int gridWidth = 2 * viewDistanceInChunks + 1;
+    const int gridMinX = startX - viewDistanceInChunks;
+    const int gridMinZ = startZ - viewDistanceInChunks;
+    int minChunkY = std::numeric_limits<int>::max();
+    int maxChunkY = std::numeric_limits<int>::min();
+    for (const auto& [coords, chunk] : chunks) {
+        if (std::abs(coords.x - startX) <= viewDistanceInChunks && std::abs(coords.z - startZ) <= viewDistanceInChunks) {
+            minChunkY = std::min(minChunkY, coords.y);
+            maxChunkY = std::max(maxChunkY, coords.y);
+        }
+    }
+    if (minChunkY > maxChunkY) {
+        return visibleChunks;
+    }
+    const int gridHeight = maxChunkY - minChunkY + 2;
+    auto cellIndex = [&](int gridX, int gridY, int gridZ) {
+        return gridX + (gridZ + gridY * gridWidth) * gridWidth;
+    };
+    searchGrid.assign(gridWidth * gridWidth * gridHeight, SearchCell());
+    
+    // Chunks above everything their column holds are open air, loaded or
+    // not. Loaded chunks are open too, and are passed through as their
+    // connectivity allows.
+    for (const auto& [coords, column] : columns) {
+        int gridX = coords.first - gridMinX;
+        int gridZ = coords.second - gridMinZ;
+        if (gridX < 0 || gridX >= gridWidth || gridZ < 0 || gridZ >= gridWidth) {
+            continue;
+        }
+        int firstAirY = std::max(floorDiv(column.maxContentY, Chunk::CHUNK_SIZE_Y) + 1 - minChunkY, 0);
+        for (int gridY = firstAirY; gridY < gridHeight; gridY++) {
+            searchGrid[cellIndex(gridX, gridY, gridZ)].open = true;
+        }
+    }
     for (const auto& [coords, chunk] : chunks) {
-        if (chunk->hasVisibleVoxels()) {
-            const auto& chunkVoxels = chunk->getVoxels();
-            visibleVoxels.insert(visibleVoxels.end(), chunkVoxels.begin(), chunkVoxels.end());
+        int gridX = coords.x - gridMinX;
+        int gridZ = coords.z - gridMinZ;
+        if (gridX < 0 || gridX >= gridWidth || gridZ < 0 || gridZ >= gridWidth) {
+            continue;
+        }
+        SearchCell& cell = searchGrid[cellIndex(gridX, coords.y - minChunkY, gridZ)];
+        cell.chunk = chunk;
+        cell.open = true;
+    }
+    
+    // Mark a cell visible and record the side it was entered by. Returns
+    // false if it was already entered by that side. A cell entered again by
+    // another side is searched again, since that side may connect to exits
+    // the first one did not.
+    auto enterCell = [](SearchCell& cell, unsigned int entrySides) {
+        if ((cell.entries & entrySides) == entrySides) {
+            return false;
+        }
+        cell.entries |= entrySides;
+        return true;
+    };
+    
+    int startY = static_cast<int>(std::floor(cameraPos.y / voxelScale / Chunk::CHUNK_SIZE_Y)) - minChunkY;
+    startY = std::min(std::max(startY, 0), gridHeight - 1);
+    SearchCell& startCell = searchGrid[cellIndex(viewDistanceInChunks, startY, viewDistanceInChunks)];
+    if (!startCell.open) {
+        return visibleChunks;
+    }
+    
+    enterCell(startCell, 0x3f);
+    searchQueue.push_back({viewDistanceInChunks, startY, viewDistanceInChunks, -1, 0});
+    for (size_t head = 0; head < searchQueue.size(); head++) {
+        SearchNode node = searchQueue[head];
+        const Chunk* chunk = searchGrid[cellIndex(node.gridX, node.gridY, node.gridZ)].chunk;
+        Chunk::Connectivity connectivity = chunk ? chunk->getMesh().connectivity : Chunk::ALL_SIDES_CONNECTED;
+        
+        for (int side = 0; side < 6; side++) {
+            // Opposite sides are adjacent in BlockFace order
+            int oppositeSide = side ^ 1;
+            if (node.directions & (1u << oppositeSide)) {
+                continue;
+            }
+            if (node.entrySide >= 0 && !Chunk::sidesConnected(connectivity, node.entrySide, side)) {
+                continue;
+            }
+            
+            int gridX = node.gridX + SIDE_STEPS[side].x;
+            int gridY = node.gridY + SIDE_STEPS[side].y;
+            int gridZ = node.gridZ + SIDE_STEPS[side].z;
+            if (gridY < 0 || gridY >= gridHeight ||
+                gridX < 0 || gridX >= gridWidth || gridZ < 0 || gridZ >= gridWidth) {
+                continue;
+            }
+            SearchCell& cell = searchGrid[cellIndex(gridX, gridY, gridZ)];
+            if (!cell.open || !enterCell(cell, 1u << oppositeSide)) {
+                continue;
+            }
+            searchQueue.push_back({gridX, gridY, gridZ, oppositeSide, node.directions | (1u << side)});
+        }
+    }
+    
+    // A chunk is visible once it has been entered by any side
+    for (int gridZ = 0; gridZ < gridWidth; gridZ++) {
+        for (int gridX = 0; gridX < gridWidth; gridX++) {
+            for (int gridY = 0; gridY + 1 < gridHeight; gridY++) {
+                const SearchCell& cell = searchGrid[cellIndex(gridX, gridY, gridZ)];
+                if (cell.chunk && cell.entries != 0) {
+                    visibleChunks.push_back(ChunkCoord(gridMinX + gridX, minChunkY + gridY, gridMinZ + gridZ));
+                }
+            }
+        }
+    }
+    
+    return visibleChunks;
+}
+
+int ChunkManager::getChunkDistance(const ChunkCoord& coords) const {
+    return std::max(std::max(std::abs(coords.x - centerChunkX), std::abs(coords.y - centerChunkY)),
+                    std::abs(coords.z - centerChunkZ));
+}
+
+bool ChunkManager::isInViewArea(int chunkX, int chunkZ) const {
+    return std::max(std::abs(chunkX - centerChunkX), std::abs(chunkZ - centerChunkZ)) <= viewDistanceInChunks;
+}
+
+int ChunkManager::getLodForDistance(int distance) const {
+    if (distance > residencyGovernor.getQuarterResolutionDistance()) {
+        return 2;
+    }
+    if (distance > residencyGovernor.getHalfResolutionDistance()) {
+        return 1;
+    }
+    return 0;
+}
+
+Chunk* ChunkManager::findChunk(const ChunkCoord& coords) const {
+    auto it = chunks.find(coords);
+    return it != chunks.end() ? it->second : nullptr;
+}
+
+Chunk* ChunkManager::locateVoxel(int voxelX, int voxelY, int voxelZ, int& localX, int& localY, int& localZ) const {
+    int chunkX = floorDiv(voxelX, Chunk::CHUNK_SIZE_X);
+    int chunkY = floorDiv(voxelY, Chunk::CHUNK_SIZE_Y);
+    int chunkZ = floorDiv(voxelZ, Chunk::CHUNK_SIZE_Z);
+    localX = voxelX - chunkX * Chunk::CHUNK_SIZE_X;
+    localY = voxelY - chunkY * Chunk::CHUNK_SIZE_Y;
+    localZ = voxelZ - chunkZ * Chunk::CHUNK_SIZE_Z;
+    return findChunk(ChunkCoord(chunkX, chunkY, chunkZ));
+}
+
+unsigned char ChunkManager::getBlockLight(int voxelX, int voxelY, int voxelZ) const {
+    int localX, localY, localZ;
+    Chunk* chunk = locateVoxel(voxelX, voxelY, voxelZ, localX, localY, localZ);
+    return chunk ? chunk->getBlockLight(localX, localY, localZ) : 0;
+}
+
+void ChunkManager::setLightLevel(Chunk* chunk, int localX, int localY, int localZ, unsigned char level) {
+    chunk->setBlockLight(localX, localY, localZ, level);
+    
+    // Neighbours sample the light of the voxels on their border too
+    ChunkCoord coords = chunk->getCoords();
+    markChunkChanged(relitChunks, coords);
+    bool borders[6] = {};
+    borders[static_cast<int>(BlockFace::TOP)] = localY == Chunk::CHUNK_SIZE_Y - 1;
+    borders[static_cast<int>(BlockFace::BOTTOM)] = localY == 0;
+    borders[static_cast<int>(BlockFace::FRONT)] = localZ == Chunk::CHUNK_SIZE_Z - 1;
+    borders[static_cast<int>(BlockFace::BACK)] = localZ == 0;
+    borders[static_cast<int>(BlockFace::LEFT)] = localX == 0;
+    borders[static_cast<int>(BlockFace::RIGHT)] = localX == Chunk::CHUNK_SIZE_X - 1;
+    for (int side = 0; side < 6; side++) {
+        if (borders[side]) {
+            markChunkChanged(relitChunks, coords + SIDE_STEPS[side]);
         }
     }
+}
+
+void ChunkManager::seedChunkLight(const ChunkCoord& coords) {
+    Chunk* chunk = findChunk(coords);
+    if (!chunk) {
+        return;
+    }
     
-    return visibleVoxels;
+    const glm::ivec3 base = coords * glm::ivec3(Chunk::CHUNK_SIZE_X, Chunk::CHUNK_SIZE_Y, Chunk::CHUNK_SIZE_Z);
+    
+    // Emitters inside the new chunk
+    for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++) {
+        for (int y = 0; y < Chunk::CHUNK_SIZE_Y; y++) {
+            for (int z = 0; z < Chunk::CHUNK_SIZE_Z; z++) {
+                unsigned int blockId = chunk->getVoxelBlockId(x, y, z);
+                if (blockId == 0) {
+                    continue;
+                }
+                unsigned char emission = getEmission(blockId);
+                if (emission > 0) {
+                    chunk->setBlockLight(x, y, z, emission);
+                    lightAddQueue.push({base.x + x, base.y + y, base.z + z, emission});
+                }
+            }
+        }
+    }
+    
+    // Lit border voxels of loaded neighbours spill into the new chunk
+    const int last = Chunk::CHUNK_SIZE_X - 1;
+    for (const ChunkCoord& step : SIDE_STEPS) {
+        Chunk* neighbor = findChunk(coords + step);
+        if (!neighbor) {
+            continue;
+        }
+        
+        const glm::ivec3 neighborBase = base + step * Chunk::CHUNK_SIZE_X;
+        for (int u = 0; u <= last; u++) {
+            for (int v = 0; v <= last; v++) {
+                // Border layer of the neighbour facing this chunk
+                glm::ivec3 local = step.x != 0 ? glm::ivec3(step.x < 0 ? last : 0, u, v) :
+                                   step.y != 0 ? glm::ivec3(u, step.y < 0 ? last : 0, v) :
+                                                 glm::ivec3(u, v, step.z < 0 ? last : 0);
+                unsigned char level = neighbor->getBlockLight(local.x, local.y, local.z);
+                if (level > 1) {
+                    glm::ivec3 voxel = neighborBase + local;
+                    lightAddQueue.push({voxel.x, voxel.y, voxel.z, level});
+                }
+            }
+        }
+    }
 }
 
-void ChunkManager::generateHeightmapForChunk(int chunkX, int chunkZ, std::vector<std::vector<int>>& heightMap) const {
-    // Ensure heightmap has proper dimensions
-    heightMap.resize(Chunk::CHUNK_SIZE_X);
-    for (auto& col : heightMap) {
-        col.resize(Chunk::CHUNK_SIZE_Z);
+void ChunkManager::processLightUpdates() {
+    if (pendingLightChanges.empty() && lightAddQueue.empty()) {
+        return;
+    }
+    PROFILE_FUNCTION();
+    
+    int localX, localY, localZ;
+    
+    // Remove the old light of every changed voxel, then flood the removal outwards
+    for (const auto& pos : pendingLightChanges) {
+        Chunk* chunk = locateVoxel(pos.x, pos.y, pos.z, localX, localY, localZ);
+        if (!chunk) {
+            continue;
+        }
+        unsigned char level = chunk->getBlockLight(localX, localY, localZ);
+        if (level > 0) {
+            setLightLevel(chunk, localX, localY, localZ, 0);
+            lightRemovalQueue.push({pos.x, pos.y, pos.z, level});
+        }
     }
+    propagateLightRemovals();
     
+    // Re-seed new emitters and let surrounding light flow into opened cells
+    for (const auto& pos : pendingLightChanges) {
+        Chunk* chunk = locateVoxel(pos.x, pos.y, pos.z, localX, localY, localZ);
+        if (!chunk) {
+            continue;
+        }
+        unsigned int blockId = chunk->getVoxelBlockId(localX, localY, localZ);
+        unsigned char emission = getEmission(blockId);
+        if (emission > 0) {
+            setLightLevel(chunk, localX, localY, localZ, emission);
+            lightAddQueue.push({pos.x, pos.y, pos.z, emission});
+        } else if (isLightTransparent(blockId)) {
+            for (int i = 0; i < 6; i++) {
+                int nx = pos.x + LIGHT_DX[i];
+                int ny = pos.y + LIGHT_DY[i];
+                int nz = pos.z + LIGHT_DZ[i];
+                int nlx, nly, nlz;
+                Chunk* neighbor = locateVoxel(nx, ny, nz, nlx, nly, nlz);
+                if (neighbor && neighbor->getBlockLight(nlx, nly, nlz) > 1) {
+                    lightAddQueue.push({nx, ny, nz, neighbor->getBlockLight(nlx, nly, nlz)});
+                }
+            }
+        }
+    }
+    pendingLightChanges.clear();
+    propagateLightAdditions();
+    
+    // One remesh per relit chunk, however many voxels changed in it
+    markChunksDirty(relitChunks);
+}
+
+void ChunkManager::propagateLightRemovals() {
+    while (!lightRemovalQueue.empty()) {
+        LightNode node = lightRemovalQueue.front();
+        lightRemovalQueue.pop();
+        
+        for (int i = 0; i < 6; i++) {
+            int nx = node.x + LIGHT_DX[i];
+            int ny = node.y + LIGHT_DY[i];
+            int nz = node.z + LIGHT_DZ[i];
+            int localX, localY, localZ;
+            Chunk* chunk = locateVoxel(nx, ny, nz, localX, localY, localZ);
+            if (!chunk) {
+                continue;
+            }
+            
+            unsigned char neighborLevel = chunk->getBlockLight(localX, localY, localZ);
+            if (neighborLevel == 0) {
+                continue;
+            }
+            
+            unsigned int neighborId = chunk->getVoxelBlockId(localX, localY, localZ);
+            if (neighborLevel < node.level && getEmission(neighborId) == 0) {
+                // Lit only by the removed source: darken and keep spreading
+                setLightLevel(chunk, localX, localY, localZ, 0);
+                lightRemovalQueue.push({nx, ny, nz, neighborLevel});
+            } else {
+                // Lit by another source: re-flood from it afterwards
+                lightAddQueue.push({nx, ny, nz, neighborLevel});
+            }
+        }
+    }
+}
+
+void ChunkManager::propagateLightAdditions() {
+    while (!lightAddQueue.empty()) {
+        LightNode node = lightAddQueue.front();
+        lightAddQueue.pop();
+        
+        int localX, localY, localZ;
+        Chunk* chunk = locateVoxel(node.x, node.y, node.z, localX, localY, localZ);
+        if (!chunk) {
+            continue;
+        }
+        
+        // The queued level may be stale if a later removal darkened the voxel
+        unsigned char level = chunk->getBlockLight(localX, localY, localZ);
+        if (level <= 1) {
+            continue;
+        }
+        
+        for (int i = 0; i < 6; i++) {
+            int nx = node.x + LIGHT_DX[i];
+            int ny = node.y + LIGHT_DY[i];
+            int nz = node.z + LIGHT_DZ[i];
+            Chunk* neighbor = locateVoxel(nx, ny, nz, localX, localY, localZ);
+            if (!neighbor) {
+                // Air loaded without storage gets it to hold the light
+                neighbor = materializeChunk(ChunkCoord(floorDiv(nx, Chunk::CHUNK_SIZE_X), floorDiv(ny, Chunk::CHUNK_SIZE_Y),
+                                                       floorDiv(nz, Chunk::CHUNK_SIZE_Z)));
+            }
+            if (!neighbor || !isLightTransparent(neighbor->getVoxelBlockId(localX, localY, localZ))) {
+                continue;
+            }
+            
+            if (neighbor->getBlockLight(localX, localY, localZ) + 2 <= level) {
+                setLightLevel(neighbor, localX, localY, localZ, level - 1);
+                lightAddQueue.push({nx, ny, nz, static_cast<unsigned char>(level - 1)});
+            }
+        }
+    }
+}
+
+void ChunkManager::generateHeightmapForChunk(int chunkX, int chunkZ, HeightMap& heightMap) const {
     // Use Perlin noise for height generation
     float frequency = 0.01f; // Adjust these parameters to control terrain
     float amplitude = 20.0f;
-    int waterLevel = 12; // Default water level
     
     for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++) {
         for (int z = 0; z < Chunk::CHUNK_SIZE_Z; z++) {
@@ -204,36 +1564,109 @@ void ChunkManager::generateHeightmapForChunk(int chunkX, int chunkZ, std::vector
             // Generate base noise value
             float noiseValue = stb_perlin_noise3(worldX, 0.0f, worldZ, 0, 0, 0);
             
-            // Apply amplitude and add base height
-            int height = static_cast<int>(noiseValue * amplitude + waterLevel + 5);
+            // Apply amplitude and add base height. Chunks stack without
+            // limit, so the height is not clamped.
+            int height = static_cast<int>(noiseValue * amplitude + WATER_LEVEL + 5);
             
-            // Clamp height to valid range
-            height = std::max(1, std::min(height, Chunk::CHUNK_SIZE_Y - 1));
-            
-            heightMap[x][z] = height;
+            heightMap[x + z * Chunk::CHUNK_SIZE_X] = height;
         }
     }
 }
 
-void ChunkManager::generateTerrainForChunk(int chunkX, int chunkZ) {
-    auto chunk = getChunk(chunkX, chunkZ);
-    if (!chunk) {
-        return;
+void ChunkManager::generateColumn(int chunkX, int chunkZ, ChunkColumn& column) const {
+    generateHeightmapForChunk(chunkX, chunkZ, column.heightMap);
+    
+    // The density field moves the ground at most OVERHANG_HEIGHT from the
+    // heightmap either way
+    column.minSurfaceY = std::numeric_limits<int>::max();
+    column.maxContentY = std::numeric_limits<int>::min();
+    for (int height : column.heightMap) {
+        column.minSurfaceY = std::min(column.minSurfaceY, height - DensityField::OVERHANG_HEIGHT);
+        column.maxContentY = std::max(column.maxContentY, std::max(height + DensityField::OVERHANG_HEIGHT, WATER_LEVEL));
     }
     
-    // Generate heightmap for this chunk
-    std::vector<std::vector<int>> heightMap;
-    generateHeightmapForChunk(chunkX, chunkZ, heightMap);
+    // Random tree placement (if biome is provided). The column decides
+    // where its trees stand once, and each of its chunks draws the part
+    // of them it holds.
+    column.treeCount = 0;
+    if (biome) {
+        for (int x = 2; x < Chunk::CHUNK_SIZE_X - 2 && column.treeCount < MAX_TREES_PER_COLUMN; ++x) {
+            for (int z = 2; z < Chunk::CHUNK_SIZE_Z - 2 && column.treeCount < MAX_TREES_PER_COLUMN; ++z) {
+                int height = column.heightMap[x + z * Chunk::CHUNK_SIZE_X];
+                if (height <= WATER_LEVEL) continue;
+                
+                int voxelX = chunkX * Chunk::CHUNK_SIZE_X + x;
+                int voxelZ = chunkZ * Chunk::CHUNK_SIZE_Z + z;
+                if (columnRandom(voxelX, voxelZ) >= TREE_DENSITY) continue;
+                
+                // Basic check for tree placement
+                bool canPlaceTree = true;
+                for (int dx = -1; dx <= 1 && canPlaceTree; ++dx) {
+                    for (int dz = -1; dz <= 1 && canPlaceTree; ++dz) {
+                        if (abs(column.heightMap[(x + dx) + (z + dz) * Chunk::CHUNK_SIZE_X] - height) > 2) {
+                            canPlaceTree = false;
+                        }
+                    }
+                }
+                if (!canPlaceTree) continue;
+                
+                // The tree stands on the highest ground the density field
+                // leaves, if there is room for it above and it is clearly
+                // solid and clear rather than on the edge of either
+                int groundY = std::numeric_limits<int>::min();
+                int airAbove = 0;
+                for (int y = height + DensityField::OVERHANG_HEIGHT; y >= height - DensityField::OVERHANG_HEIGHT; y--) {
+                    float density = DensityField::sampleVoxel(voxelX, y, voxelZ, height);
+                    if (density > 0.0f) {
+                        if (density > TREE_DENSITY_MARGIN && airAbove >= TREE_HEIGHT) {
+                            groundY = y;
+                        }
+                        break;
+                    }
+                    airAbove = density < -TREE_DENSITY_MARGIN ? airAbove + 1 : 0;
+                }
+                
+                if (groundY > WATER_LEVEL) {
+                    column.trees[column.treeCount++] = {static_cast<uint8_t>(x), static_cast<uint8_t>(z), groundY};
+                    column.maxContentY = std::max(column.maxContentY, groundY + TREE_HEIGHT);
+                }
+            }
+        }
+    }
     
-    // Water level
-    int waterLevel = 12;
+    column.minLoadedY = std::numeric_limits<int>::max();
+    column.maxLoadedY = std::numeric_limits<int>::min();
+    column.bandCenterY = std::numeric_limits<int>::min();
+}
+
+void ChunkManager::generateTerrainForChunk(int chunkX, int chunkY, int chunkZ) {
+    PROFILE_FUNCTION();
     
-    // Generate terrain based on heightmap
+    Chunk* chunk = findChunk(ChunkCoord(chunkX, chunkY, chunkZ));
+    auto column = columns.find(std::make_pair(chunkX, chunkZ));
+    if (chunk && column != columns.end()) {
+        generateTerrain(*chunk, column->second);
+        chunk->markDirty();
+    }
+}
+
+void ChunkManager::generateTerrain(Chunk& chunk, const ChunkColumn& column) const {
+    const glm::ivec3 coords = chunk.getCoords();
+    const HeightMap& heightMap = column.heightMap;
+    const int baseY = coords.y * Chunk::CHUNK_SIZE_Y;
+    
+    thread_local std::unique_ptr<TerrainScratch> scratch = std::make_unique<TerrainScratch>();
+    DensityField::SolidMask& solid = scratch->solid;
+    DensityField::sampleChunk(coords.x, coords.y, coords.z, heightMap, solid);
+    
+    // Fill each voxel column from the top down, counting how deep below
+    // the last air each solid voxel is
     for (int x = 0; x < Chunk::CHUNK_SIZE_X; x++) {
         for (int z = 0; z < Chunk::CHUNK_SIZE_Z; z++) {
-            int height = heightMap[x][z];
+            int height = heightMap[x + z * Chunk::CHUNK_SIZE_X];
             
-            // Check if voxel has neighbors with water
+            // Check if voxel has neighbors with water. Neighbours in other
+            // columns are not checked, border effects are small.
             bool isNearWater = false;
             const int dx[] = {-1, 1, 0, 0};
             const int dz[] = {0, 0, -1, 1};
@@ -242,126 +1675,75 @@ void ChunkManager::generateTerrainForChunk(int chunkX, int chunkZ) {
                 int nx = x + dx[i];
                 int nz = z + dz[i];
                 
-                if (nx >= 0 && nx < Chunk::CHUNK_SIZE_X && nz >= 0 && nz < Chunk::CHUNK_SIZE_Z) {
-                    if (heightMap[nx][nz] < waterLevel) {
-                        isNearWater = true;
-                        break;
-                    }
-                } else {
-                    // Check neighboring chunks
-                    int neighborChunkX = chunkX;
-                    int neighborChunkZ = chunkZ;
-                    int neighborX = nx;
-                    int neighborZ = nz;
-                    
-                    if (nx < 0) {
-                        neighborChunkX--;
-                        neighborX = Chunk::CHUNK_SIZE_X + nx;
-                    } else if (nx >= Chunk::CHUNK_SIZE_X) {
-                        neighborChunkX++;
-                        neighborX = nx - Chunk::CHUNK_SIZE_X;
-                    }
-                    
-                    if (nz < 0) {
-                        neighborChunkZ--;
-                        neighborZ = Chunk::CHUNK_SIZE_Z + nz;
-                    } else if (nz >= Chunk::CHUNK_SIZE_Z) {
-                        neighborChunkZ++;
-                        neighborZ = nz - Chunk::CHUNK_SIZE_Z;
-                    }
-                    
-                    auto neighborChunk = getChunk(neighborChunkX, neighborChunkZ);
-                    if (neighborChunk) {
-                        // Get height from neighboring chunk if available
-                        // We'll skip this for simplicity, assuming chunk borders won't affect the water check much
-                    }
+                if (nx >= 0 && nx < Chunk::CHUNK_SIZE_X && nz >= 0 && nz < Chunk::CHUNK_SIZE_Z &&
+                    heightMap[nx + nz * Chunk::CHUNK_SIZE_X] < WATER_LEVEL) {
+                    isNearWater = true;
+                    break;
                 }
             }
             
-            // Fill terrain from bottom to height
-            for (int y = 0; y <= height; y++) {
-                unsigned int blockId;
+            int depth = 0;
+            bool solidAbove = false;
+            for (int y = DensityField::ROWS - 1; y >= 0; y--) {
+                bool isSolid = solid[x + (z + y * Chunk::CHUNK_SIZE_Z) * Chunk::CHUNK_SIZE_X] != 0;
+                depth = isSolid && solidAbove ? std::min(depth + 1, 3) : 0;
+                solidAbove = isSolid;
+                if (y >= Chunk::CHUNK_SIZE_Y) {
+                    continue;
+                }
                 
-                if (y == height) {
-                    if (height <= waterLevel && isNearWater) {
-                        blockId = 8; // Sand near water
-                    } else {
-                        blockId = 1; // Grass on top
+                int voxelY = baseY + y;
+                unsigned int blockId = 0;
+                if (!isSolid) {
+                    if (voxelY > height && voxelY <= WATER_LEVEL) {
+                        blockId = 7; // Water
                     }
-                } else if (y > height - 3) {
+                } else if (depth >= 3 || voxelY <= height - 3) {
+                    blockId = 3; // Stone beneath, and around caves
+                } else if (depth > 0) {
                     blockId = 2; // Dirt layer
+                } else if (height <= WATER_LEVEL && voxelY <= WATER_LEVEL && isNearWater) {
+                    blockId = 8; // Sand near water
                 } else {
-                    blockId = 3; // Stone beneath
+                    blockId = 1; // Grass on top
                 }
                 
-                chunk->setVoxel(x, y, z, blockId);
-            }
-            
-            // Fill water
-            for (int y = height + 1; y <= waterLevel; y++) {
-                if (height < waterLevel) {
-                    chunk->setVoxel(x, y, z, 7); // Water
-                }
+                chunk.exchangeVoxel(x, y, z, blockId);
             }
         }
     }
     
-    // Random tree placement (if biome is provided)
-    if (biome) {
-        float treeDensity = 0.01f;
+    // Trees the column placed, clipped to this chunk
+    for (int i = 0; i < column.treeCount; i++) {
+        const ColumnTree& tree = column.trees[i];
+        const int x = tree.x;
+        const int z = tree.z;
+        int height = tree.groundY;
         
-        for (int x = 2; x < Chunk::CHUNK_SIZE_X - 2; ++x) {
-            for (int z = 2; z < Chunk::CHUNK_SIZE_Z - 2; ++z) {
-                if ((static_cast<float>(rand()) / RAND_MAX) < treeDensity) {
-                    int height = heightMap[x][z];
-                    
-                    if (height <= waterLevel) continue;
+        // Place tree trunk (3 blocks tall)
+        for (int y = 1; y <= 3; y++) {
+            int trunkY = height + y - baseY;
+            if (trunkY >= 0 && trunkY < Chunk::CHUNK_SIZE_Y) {
+                chunk.exchangeVoxel(x, trunkY, z, 4); // Wood
+            }
+        }
+        
+        // Place leaves
+        for (int lx = -2; lx <= 2; lx++) {
+            for (int ly = 3; ly <= TREE_HEIGHT; ly++) {
+                for (int lz = -2; lz <= 2; lz++) {
+                    // Skip if too far (make a rough sphere)
+                    if (lx*lx + (ly-4)*(ly-4) + lz*lz > 5) continue;
                     
-                    // Basic check for tree placement
-                    bool canPlaceTree = true;
-                    for (int dx = -1; dx <= 1 && canPlaceTree; ++dx) {
-                        for (int dz = -1; dz <= 1 && canPlaceTree; ++dz) {
-                            int nx = x + dx;
-                            int nz = z + dz;
-                            
-                            if (nx >= 0 && nx < Chunk::CHUNK_SIZE_X && nz >= 0 && nz < Chunk::CHUNK_SIZE_Z) {
-                                if (abs(heightMap[nx][nz] - height) > 2) {
-                                    canPlaceTree = false;
-                                }
-                            }
-                        }
-                    }
+                    // Don't replace existing trunk blocks
+                    if (lx == 0 && lz == 0 && ly < 4) continue;
                     
-                    if (canPlaceTree) {
-                        // Place tree trunk (3 blocks tall)
-                        for (int y = 1; y <= 3; y++) {
-                            chunk->setVoxel(x, height + y, z, 4); // Wood
-                        }
-                        
-                        // Place leaves
-                        for (int lx = -2; lx <= 2; lx++) {
-                            for (int ly = 3; ly <= 5; ly++) {
-                                for (int lz = -2; lz <= 2; lz++) {
-                                    // Skip if too far (make a rough sphere)
-                                    if (lx*lx + (ly-4)*(ly-4) + lz*lz > 5) continue;
-                                    
-                                    // Don't replace existing trunk blocks
-                                    if (lx == 0 && lz == 0 && ly < 4) continue;
-                                    
-                                    // Check if we're still in this chunk
-                                    int leafX = x + lx;
-                                    int leafY = height + ly;
-                                    int leafZ = z + lz;
-                                    
-                                    if (chunk->isValidLocalPosition(leafX, leafY, leafZ)) {
-                                        chunk->setVoxel(leafX, leafY, leafZ, 5); // Leaves
-                                    }
-                                }
-                            }
-                        }
+                    int leafY = height + ly - baseY;
+                    if (leafY >= 0 && leafY < Chunk::CHUNK_SIZE_Y) {
+                        chunk.exchangeVoxel(x + lx, leafY, z + lz, 5); // Leaves
                     }
                 }
             }
         }
     }
-}
\ No newline at end of file
+}
@@ -2,20 +2,76 @@
 #define CHUNK_MANAGER_H
 
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <queue>
+#include <mutex>
+#include <functional>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include "Chunk.h"
+#include "ChunkPool.h"
+#include "SnapshotPool.h"
+#include "ResidencyGovernor.h"
 #include "../Utils/ConfigReader.h"
+#include "../Utils/ThreadPool.h"
 #include "Voxel.h"
 #include "Generation/Biome.h"
+#include "Generation/DensityField.h"
+
+// Chunk coordinates (in chunk space); chunk y counts cubes up from voxel y 0
+using ChunkCoord = glm::ivec3;
 
 // Hash function for chunk coordinates
 struct ChunkCoordHash {
+    std::size_t operator()(const ChunkCoord& coord) const {
+        return static_cast<std::size_t>(coord.x) * 73856093u ^
+               static_cast<std::size_t>(coord.y) * 19349663u ^
+               static_cast<std::size_t>(coord.z) * 83492791u;
+    }
+};
+
+// Hash function for the (x, z) chunk coordinates of a column
+struct ColumnCoordHash {
     std::size_t operator()(const std::pair<int, int>& coord) const {
         return std::hash<int>()(coord.first) ^ (std::hash<int>()(coord.second) << 1);
     }
 };
 
+// Streaming counters, read by the headless benchmark mode
+struct ChunkStreamingStats {
+    uint64_t chunksLoaded = 0;
+    uint64_t emptyChunksLoaded = 0;  // Loaded as air only, without storage
+    uint64_t meshesBuilt = 0;
+    uint64_t meshedFaces = 0;
+    uint64_t meshingNs = 0;  // Summed over the main thread and the workers
+    uint64_t generationNs = 0;  // Terrain generation, summed the same way
+    std::vector<uint64_t> loadLatencyNs;  // Load request (or, if prefetched, entering the view area) to first mesh
+    
+    // Prefetching: chunk columns loaded ahead of the view area, and chunks
+    // ahead of the vertical band as the camera climbs or falls. Of the
+    // columns and band chunks that entered the view after the first update,
+    // those that were ready (prefetched) and those loaded on the spot.
+    uint64_t chunksPrefetched = 0;
+    uint64_t prefetchHits = 0;
+    uint64_t prefetchMisses = 0;
+    uint64_t prefetchWasted = 0;  // Unloaded again before entering the view area
+};
+
+// Voxels of a chunk and its six neighbours, each frozen at the version
+// current when the view was taken. Any thread may read a view without
+// locks; later edits give the chunks new versions and leave it as it was.
+struct ChunkSnapshotView {
+    Chunk::SnapshotPtr center;
+    std::array<Chunk::SnapshotPtr, 6> neighbors;  // -X, +X, -Z, +Z, -Y, +Y; null when not loaded or only air
+};
+
+// One voxel write of a bulk edit, in world voxel coordinates
+struct VoxelEdit {
+    glm::ivec3 voxel;
+    unsigned int blockId;
+};
+
 class ChunkManager {
 public:
     ChunkManager(Config& config);
@@ -24,53 +80,325 @@ public:
     // Initialize the chunk manager with a biome for terrain generation
     void init(Biome& biome);
     
-    // Chunk operations
-    void loadChunk(int chunkX, int chunkZ);
-    void unloadChunk(int chunkX, int chunkZ);
-    bool isChunkLoaded(int chunkX, int chunkZ) const;
+    // Chunk operations. Loading a chunk loads its column's metadata first.
+    // Chunks above everything their column holds are loaded as air, without
+    // storage: they count as loaded, but getChunk returns null for them
+    // until an edit puts a block in them.
+    void loadChunk(int chunkX, int chunkY, int chunkZ);
+    void unloadChunk(int chunkX, int chunkY, int chunkZ);
+    bool isChunkLoaded(int chunkX, int chunkY, int chunkZ) const;
+    bool isColumnLoaded(int chunkX, int chunkZ) const;
+    
+    // Get chunk by coordinates. Chunks live in a pool and are recycled once
+    // unloaded, so the pointer is only valid until the next updateChunks.
+    Chunk* getChunk(int chunkX, int chunkY, int chunkZ) const;
     
-    // Get chunk by coordinates
-    std::shared_ptr<Chunk> getChunk(int chunkX, int chunkZ) const;
+    // Trees reach this many voxels above the ground they stand on
+    static constexpr int TREE_HEIGHT = 5;
     
-    // Convert world position to chunk coordinates
+    // Height of the terrain's base surface at a voxel column, from its chunk
+    // column's metadata. Overhangs and caves can move the actual ground up
+    // to DensityField::OVERHANG_HEIGHT voxels above or below it. Returns
+    // false when the column is not loaded.
+    bool getSurfaceHeight(int voxelX, int voxelZ, int& height) const;
+    
+    // Immutable snapshots for work on other threads. Taking one copies the
+    // chunk only if no snapshot of its current version is still held.
+    // Results computed from a snapshot are stale once isSnapshotCurrent is
+    // false, and should be dropped. Main thread only; returns null (or an
+    // empty view) when the chunk is not loaded.
+    Chunk::SnapshotPtr getChunkSnapshot(int chunkX, int chunkY, int chunkZ);
+    ChunkSnapshotView getSnapshotView(int chunkX, int chunkY, int chunkZ);
+    bool isSnapshotCurrent(const Chunk::VoxelSnapshot& snapshot) const;
+    
+    // Convert world position to chunk coordinates, with or without the height
     void worldToChunkCoords(const glm::vec3& worldPos, int& chunkX, int& chunkZ) const;
+    void worldToChunkCoords(const glm::vec3& worldPos, int& chunkX, int& chunkY, int& chunkZ) const;
+    
+    // World-space box covered by a chunk's voxels
+    void getChunkWorldBounds(int chunkX, int chunkY, int chunkZ, glm::vec3& minCorner, glm::vec3& maxCorner) const;
     
     // Get chunk at world position
-    std::shared_ptr<Chunk> getChunkAtPosition(const glm::vec3& worldPos) const;
+    Chunk* getChunkAtPosition(const glm::vec3& worldPos) const;
     
     // Voxel operations that work across chunks
     unsigned int getVoxelBlockId(const glm::vec3& worldPos) const;
     void setVoxel(const glm::vec3& worldPos, unsigned int blockId);
     bool isVoxelSolid(const glm::vec3& worldPos) const;
     
-    // Update chunk loading based on camera position
-    void updateChunks(const glm::vec3& cameraPos);
+    // Bulk edits in world voxel coordinates. Writes are grouped by chunk and
+    // stored directly; each chunk they change, and each neighbour whose
+    // border they touch, is marked dirty once, so it is remeshed once.
+    // Voxels in unloaded chunks are skipped. Each returns the number of
+    // voxels whose block changed.
+    size_t fillBox(const glm::ivec3& minVoxel, const glm::ivec3& maxVoxel, unsigned int blockId);  // Inclusive
+    size_t fillSphere(const glm::ivec3& center, int radius, unsigned int blockId);
+    size_t applyEdits(const std::vector<VoxelEdit>& edits);  // In order, so later writes win
+    
+    // Block light at integer voxel coordinates (0 if the chunk is not loaded)
+    unsigned char getBlockLight(int voxelX, int voxelY, int voxelZ) const;
+    
+    // Relight every voxel changed since the last call and mark the affected
+    // chunks dirty. Called once per frame from updateChunks.
+    void processLightUpdates();
+    
+    // Update chunk loading based on camera position. Every column within
+    // view distance is loaded right away: the chunks holding its surface,
+    // and those within the vertical view distance of the camera's chunk (see
+    // StreamingConfig). With a memory budget, the view distance and LOD
+    // rings are first fitted to it (see ResidencyGovernor). With the
+    // camera's velocity (world units per second) and view direction, columns
+    // along its predicted path, and the chunks its band will reach, are also
+    // loaded ahead, a few per call (see PrefetchConfig).
+    void updateChunks(const glm::vec3& cameraPos, const glm::vec3& velocity = glm::vec3(0.0f),
+                      const glm::vec3& viewDirection = glm::vec3(0.0f));
+    
+    // Chunks whose mesh was rebuilt, switched level or which were unloaded
+    // during the last updateChunks call. The renderer re-uploads (or drops) their meshes and
+    // invalidates the cached shadow maps covering them.
+    const std::vector<ChunkCoord>& getChangedChunks() const { return changedChunks; }
+    
+    // Breadth-first search over chunks from the camera's chunk. A chunk is
+    // left only through sides its connectivity joins to the side it was
+    // entered by, and never back towards the camera, so chunks behind hills
+    // or in sealed caves are never reached and need not be drawn. Chunks
+    // that are not loaded are passed through when they lie above everything
+    // their column holds, and block the search otherwise. Returns the loaded
+    // chunks reached, valid until the next call.
+    const std::vector<ChunkCoord>& findVisibleChunks(const glm::vec3& cameraPos);
+    
+    // Mesh detail level used for chunks `distance` chunks (Chebyshev, in
+    // all three axes) away from the camera's chunk
+    int getLodForDistance(int distance) const;
+    
+    // Current view distance, and the governor's reasons for it
+    int getViewDistance() const { return viewDistanceInChunks; }
+    const ResidencyGovernor& getResidencyGovernor() const { return residencyGovernor; }
+    
+    // Block until every reduced mesh requested so far is built and applied.
+    // Chunks it changes are appended to getChangedChunks().
+    void finishPendingMeshes();
     
-    // Get mesh for rendering
-    std::vector<Voxel> getVisibleVoxels() const;
+    // Generate a loaded chunk's terrain again, on the calling thread.
+    // Chunks loaded by updateChunks are generated on the workers.
+    void generateTerrainForChunk(int chunkX, int chunkY, int chunkZ);
     
-    // Terrain generation methods
-    void generateTerrainForChunk(int chunkX, int chunkZ);
+    // Streaming statistics since construction or the last reset. A reset
+    // keeps the capacity of the latency log.
+    const ChunkStreamingStats& getStreamingStats() const { return streamingStats; }
+    void resetStreamingStats();
 
 private:
-    // Map of loaded chunks
-    std::unordered_map<std::pair<int, int>, std::shared_ptr<Chunk>, ChunkCoordHash> chunks;
+    // Base surface height of every voxel column of a chunk column, at x + z * CHUNK_SIZE_X
+    using HeightMap = DensityField::HeightMap;
+    
+    // A tree of a column: the voxel column it grows from, and the ground
+    // voxel it stands on, which overhangs can move off the heightmap
+    struct ColumnTree {
+        uint8_t x;
+        uint8_t z;
+        int groundY;
+    };
+    static const int MAX_TREES_PER_COLUMN = 8;
+    
+    // What the chunks of a column share, made when its first chunk loads
+    // and kept until the column is unloaded: the terrain surface, for
+    // surface queries and to tell which chunks hold anything without
+    // generating them
+    struct ChunkColumn {
+        HeightMap heightMap;
+        std::array<ColumnTree, MAX_TREES_PER_COLUMN> trees;
+        int treeCount;
+        int minSurfaceY;  // Lowest the ground reaches, moved down by the density field
+        int maxContentY;  // Highest voxel that may not be air: terrain, water, trees and edits
+        int minLoadedY;   // Range of chunk y that may be loaded
+        int maxLoadedY;
+        int bandCenterY;  // Camera chunk y the loaded chunks were chosen for
+        TrackedAllocation memory{MemoryTag::ChunkColumns, sizeof(ChunkColumn)};
+    };
+    
+    // Map of loaded chunks, which are owned by chunkPool. Chunks loaded as
+    // air only have no storage and map to null.
+    std::unordered_map<ChunkCoord, Chunk*, ChunkCoordHash> chunks;
+    
+    // Columns with chunks loaded, by chunk (x, z)
+    std::unordered_map<std::pair<int, int>, ChunkColumn, ColumnCoordHash> columns;
+    
+    // Map nodes of unloaded chunks and columns, reused by the next loads so
+    // streaming allocates nothing once they have warmed up. Released when
+    // the view shrinks, like the chunk pool's spare slots.
+    std::vector<decltype(chunks)::node_type> spareChunkNodes;
+    std::vector<decltype(columns)::node_type> spareColumnNodes;
     
     // Config reference
     Config& config;
     
-    // View distance in chunks
+    // Fits the view distance and LOD rings to the memory budget
+    ResidencyGovernor residencyGovernor;
+    
+    // View distance in chunks, as set by residencyGovernor, and chunks
+    // loaded above and below the camera's
     int viewDistanceInChunks;
+    int verticalViewDistance;
     
     // Voxel scale
     float voxelScale;
     
+    // Storage for every chunk within the configured view distance
+    ChunkPool chunkPool;
+    
     // Biome reference for terrain generation
     Biome* biome = nullptr;
     
+    // Block light flood fill state
+    struct LightNode {
+        int x, y, z;
+        unsigned char level;
+    };
+    std::vector<glm::ivec3> pendingLightChanges;  // Voxels whose block changed this frame
+    std::queue<LightNode> lightAddQueue;
+    std::queue<LightNode> lightRemovalQueue;
+    
+    // Chunks changed since they were last marked dirty. Their set nodes
+    // are kept in spareDirtyNodes for the next changes.
+    using DirtyChunkSet = std::unordered_set<ChunkCoord, ChunkCoordHash>;
+    DirtyChunkSet relitChunks;
+    std::vector<DirtyChunkSet::node_type> spareDirtyNodes;
+    
+    // Bulk edit state: what one edit changed in a chunk, the chunks to mark
+    // dirty when the edit is done, and applyEdits' list as (chunk, index)
+    // pairs sorted by chunk
+    struct ChunkEdit {
+        size_t voxelsChanged = 0;
+        bool borders[6] = {};  // Changed voxels on the -X, +X, -Y, +Y, -Z and +Z sides
+    };
+    DirtyChunkSet editedChunks;
+    std::vector<std::pair<uint64_t, uint32_t>> editOrder;
+    
+    // Chunks remeshed or unloaded by the current updateChunks call
+    std::vector<ChunkCoord> changedChunks;
+    
+    // Chunk the camera was in at the last updateChunks call
+    int centerChunkX = 0;
+    int centerChunkY = 0;
+    int centerChunkZ = 0;
+    bool viewAreaLoaded = false;  // Set by the first updateChunks call
+    
+    // Columns outside the view area on the predicted path, soonest needed
+    // first, and the loaded ones among them that were loaded ahead
+    std::vector<std::pair<int, int>> prefetchCandidates;
+    std::vector<std::pair<int, int>> prefetchedColumns;
+    
+    // Chunk y range the vertical band will sweep over the look-ahead, and
+    // the chunks loaded ahead in it that have not entered the band yet
+    int prefetchMinY = 0;
+    int prefetchMaxY = 0;
+    std::vector<ChunkCoord> prefetchedChunks;
+    
+    // Snapshots handed to other threads
+    std::shared_ptr<SnapshotPool> snapshotPool;
+    
+    // Reduced meshes are built on the worker pool from voxel snapshots queued
+    // in lodJobs, and handed back through lodResults; at most one build per
+    // chunk is queued. Mesh buffers are recycled through spareMeshes, so a
+    // build allocates nothing once they have warmed up. lodResultMutex
+    // guards lodJobs, lodResults and spareMeshes.
+    struct LodMeshJob {
+        int level;
+        Chunk::SnapshotPtr snapshot;
+        // Neighbours drawn at the same level, in BlockFace order
+        std::array<Chunk::SnapshotPtr, 6> neighbors;
+    };
+    struct LodMeshResult {
+        ChunkCoord coords;
+        int level;
+        uint64_t version;
+        Chunk::Mesh mesh;
+        uint64_t buildNs;
+    };
+    std::mutex lodResultMutex;
+    std::vector<LodMeshJob> lodJobs;
+    std::vector<LodMeshResult> lodResults;
+    std::vector<Chunk::Mesh> spareMeshes;
+    // Main thread only: results being applied, and the chunks with a build
+    // queued (a few per worker, so a list is searched faster than a set)
+    std::vector<LodMeshResult> appliedLodResults;
+    std::vector<ChunkCoord> lodBuildsInFlight;
+    
+    // Per-update scratch lists, kept to reuse their storage
+    std::vector<std::pair<int, int>> columnsToUnload;
+    std::vector<std::pair<int, ChunkCoord>> lodRequests;
+    
+    // Visibility search state, kept between calls to reuse its storage. The
+    // grid has one cell per chunk.
+    struct SearchCell {
+        const Chunk* chunk = nullptr;  // Null for air
+        bool open = false;             // Loaded, or known to be air
+        uint8_t entries = 0;           // Bit s for each side s the chunk was entered by
+    };
+    struct SearchNode {
+        int gridX, gridY, gridZ;
+        int entrySide;            // -1 for the camera's chunk
+        unsigned int directions;  // Sides stepped through on the way here
+    };
+    std::vector<SearchCell> searchGrid;
+    std::vector<SearchNode> searchQueue;
+    std::vector<ChunkCoord> visibleChunks;
+    
+    // Streaming statistics and the load request time of chunks not yet meshed
+    ChunkStreamingStats streamingStats;
+    std::unordered_map<ChunkCoord, uint64_t, ChunkCoordHash> pendingLoadStartNs;
+    std::vector<decltype(pendingLoadStartNs)::node_type> spareLoadStartNodes;
+    
+    // Chunks loaded but not generated yet. They are generated together on
+    // the workers by generatePendingTerrain before anything reads them.
+    std::vector<ChunkCoord> pendingTerrain;
+    
+    // Declared last so the workers stop before anything they write to is destroyed
+    ThreadPool workerPool;
+    
+    // What happened to a chunk that reduced neighbours may have culled
+    // faces against (see remeshReducedNeighbors)
+    enum class NeighborChange { Level, Blocks, Unload };
+    
     // Helper methods
+    void beginLoadChunk(int chunkX, int chunkY, int chunkZ);
+    void generatePendingTerrain();
+    void generateTerrain(Chunk& chunk, const ChunkColumn& column) const;
+    ChunkColumn& loadColumnData(int chunkX, int chunkZ);
+    void generateColumn(int chunkX, int chunkZ, ChunkColumn& column) const;
+    void loadColumn(int chunkX, int chunkZ);
+    void unloadColumn(int chunkX, int chunkZ);
+    void updateColumnChunks(int chunkX, int chunkZ, ChunkColumn& column);
+    void remeshNeighbors(const ChunkCoord& coords);
+    void remeshReducedNeighbors(const ChunkCoord& coords, NeighborChange change);
+    bool isDrawnAtLevel(const ChunkCoord& coords, int level) const;
+    unsigned int getSharedSides(const ChunkCoord& coords, int level) const;
+    Chunk* materializeChunk(const ChunkCoord& coords);
     void updateChunkMeshes();
-    void generateHeightmapForChunk(int chunkX, int chunkZ, std::vector<std::vector<int>>& heightMap) const;
+    void applyLodMeshes();
+    void requestLodMeshes(std::vector<std::pair<int, ChunkCoord>>& requests);
+    void buildQueuedLodMesh();
+    void findPrefetchCandidates(const glm::vec3& cameraPos, const glm::vec3& velocity, const glm::vec3& viewDirection);
+    void prefetchChunks();
+    bool isLodBuildInFlight(const ChunkCoord& coords) const;
+    void recordChunkMeshed(const ChunkCoord& coords, size_t faceCount, uint64_t buildNs, uint64_t endNs);
+    int getChunkDistance(const ChunkCoord& coords) const;
+    bool isInViewArea(int chunkX, int chunkZ) const;
+    Chunk* findChunk(const ChunkCoord& coords) const;
+    Chunk* locateVoxel(int voxelX, int voxelY, int voxelZ, int& localX, int& localY, int& localZ) const;
+    void editVoxel(Chunk& chunk, int localX, int localY, int localZ, unsigned int blockId, ChunkEdit& edit);
+    void finishChunkEdit(const Chunk& chunk, const ChunkEdit& edit);
+    void finishBulkEdit();
+    void markChunkChanged(DirtyChunkSet& dirtyChunks, const ChunkCoord& coords);
+    void markChunksDirty(DirtyChunkSet& dirtyChunks);
+    size_t fillRows(const glm::ivec3& minVoxel, const glm::ivec3& maxVoxel, unsigned int blockId,
+                    const std::function<bool(int voxelY, int voxelZ, int& minX, int& maxX)>& rowSpan);
+    void setLightLevel(Chunk* chunk, int localX, int localY, int localZ, unsigned char level);
+    void seedChunkLight(const ChunkCoord& coords);
+    void propagateLightRemovals();
+    void propagateLightAdditions();
+    void generateHeightmapForChunk(int chunkX, int chunkZ, HeightMap& heightMap) const;
 };
 
 #endif // CHUNK_MANAGER_H
\ No newline at end of file
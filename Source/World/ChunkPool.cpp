@@ -0,0 +1,87 @@
+#include "ChunkPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+ChunkPool::ChunkPool(size_t capacity, float voxelScale, bool useHugePages)
+    : capacity(capacity), voxelScale(voxelScale) {
+    size_t bytes = capacity * sizeof(Chunk);
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+        mappedBytes = bytes;
+#ifdef MADV_HUGEPAGE
+        if (useHugePages && madvise(memory, bytes, MADV_HUGEPAGE) != 0) {
+            std::cerr << "Warning: huge pages are not available for the chunk pool" << std::endl;
+        }
+#else
+        if (useHugePages) {
+            std::cerr << "Warning: huge pages are not supported on this platform" << std::endl;
+        }
+#endif
+    } else {
+        std::cerr << "Warning: failed to map " << bytes << " bytes for the chunk pool, using the heap" << std::endl;
+        memory = ::operator new(bytes, std::align_val_t(alignof(Chunk)));
+    }
+    slots = static_cast<Chunk*>(memory);
+    freeChunks.reserve(capacity);
+    vacantSlots.reserve(capacity);
+}
+
+ChunkPool::~ChunkPool() {
+    std::sort(vacantSlots.begin(), vacantSlots.end());
+    for (size_t i = 0; i < constructedCount; i++) {
+        if (!std::binary_search(vacantSlots.begin(), vacantSlots.end(), &slots[i])) {
+            slots[i].~Chunk();
+        }
+    }
+    if (mappedBytes > 0) {
+        munmap(slots, mappedBytes);
+    } else {
+        ::operator delete(slots, std::align_val_t(alignof(Chunk)));
+    }
+}
+
+Chunk* ChunkPool::acquire(int chunkX, int chunkY, int chunkZ) {
+    if (!freeChunks.empty()) {
+        Chunk* chunk = freeChunks.back();
+        freeChunks.pop_back();
+        chunk->reset(chunkX, chunkY, chunkZ);
+        return chunk;
+    }
+    if (!vacantSlots.empty()) {
+        Chunk* slot = vacantSlots.back();
+        vacantSlots.pop_back();
+        return new (slot) Chunk(chunkX, chunkY, chunkZ, voxelScale);
+    }
+    if (constructedCount < capacity) {
+        return new (&slots[constructedCount++]) Chunk(chunkX, chunkY, chunkZ, voxelScale);
+    }
+    return nullptr;
+}
+
+void ChunkPool::release(Chunk* chunk) {
+    freeChunks.push_back(chunk);
+}
+
+size_t ChunkPool::trim() {
+    // Only whole pages inside a slot can be dropped; the pages a slot shares
+    // with its neighbours stay
+    const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    size_t freed = freeChunks.size();
+    for (Chunk* chunk : freeChunks) {
+        chunk->~Chunk();
+        if (mappedBytes > 0) {
+            uintptr_t begin = (reinterpret_cast<uintptr_t>(chunk) + pageSize - 1) & ~(pageSize - 1);
+            uintptr_t end = reinterpret_cast<uintptr_t>(chunk + 1) & ~(pageSize - 1);
+            if (end > begin) {
+                madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+            }
+        }
+        vacantSlots.push_back(chunk);
+    }
+    freeChunks.clear();
+    return freed;
+}
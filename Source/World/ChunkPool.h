@@ -0,0 +1,46 @@
+#ifndef CHUNK_POOL_H
+#define CHUNK_POOL_H
+
+#include <cstddef>
+#include <vector>
+#include "Chunk.h"
+
+// Fixed-capacity storage for the loaded chunks, reserved once up front.
+// Slots are constructed the first time they are used; released chunks go
+// on a free list and are reset for the next load, so streaming never goes
+// through the general-purpose allocator and a reused chunk keeps the
+// capacity of its mesh buffers.
+class ChunkPool {
+public:
+    // The slots are one anonymous mapping, only committed as it is touched.
+    // With useHugePages the kernel is asked to back it with huge pages.
+    ChunkPool(size_t capacity, float voxelScale, bool useHugePages);
+    ~ChunkPool();
+
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    // A chunk reset for the given coordinates, or nullptr when every slot
+    // is in use
+    Chunk* acquire(int chunkX, int chunkY, int chunkZ);
+    void release(Chunk* chunk);
+
+    // Destroy the released chunks and hand their pages back to the system,
+    // for when fewer chunks will be loaded from now on. Their slots are
+    // constructed again when next needed. Returns the number of chunks freed.
+    size_t trim();
+
+    size_t getCapacity() const { return capacity; }
+    size_t getUsedCount() const { return constructedCount - freeChunks.size() - vacantSlots.size(); }
+
+private:
+    size_t capacity;
+    float voxelScale;
+    Chunk* slots = nullptr;
+    size_t mappedBytes = 0;  // 0 when the slots came from operator new
+    size_t constructedCount = 0;
+    std::vector<Chunk*> freeChunks;
+    std::vector<Chunk*> vacantSlots;  // Constructed once, destroyed by trim()
+};
+
+#endif // CHUNK_POOL_H
@@ -49,9 +49,8 @@ void BasicBiome::placeTrees(std::vector<Voxel>& voxels, const std::vector<std::v
 
                 if (canPlaceTree) {
                     glm::vec3 treePos(x * voxelScale, (height + 1) * voxelScale, z * voxelScale);
-                    auto tree = std::make_unique<Tree>(treePos, voxelScale);
-                    auto treeVoxels = tree->getVoxels();
-                    voxels.insert(voxels.end(), treeVoxels.begin(), treeVoxels.end());
+                    Tree tree(treePos, voxelScale);
+                    tree.appendVoxels(voxels);
                 }
             }
         }
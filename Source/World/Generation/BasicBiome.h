@@ -3,7 +3,6 @@
 #include "Biome.h"
 #include <random>
 #include "../../Models/Tree.h"
-#include <memory>
 
 class BasicBiome : public Biome {
 private:
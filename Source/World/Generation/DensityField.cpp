@@ -0,0 +1,221 @@
+#include "DensityField.h"
+#include <algorithm>
+#include <memory>
+#include "stb_perlin.h"
+#include "../../Utils/MemoryTracker.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DENSITY_FIELD_SSE
+#endif
+
+namespace {
+    // Overhang noise is squeezed vertically into ledges, and amplified so
+    // it is steep enough to turn the ground back over itself
+    const float OVERHANG_FREQUENCY = 0.043f;
+    const float OVERHANG_VERTICAL_FREQUENCY = 0.086f;
+    const float OVERHANG_GAIN = 2.5f;
+    const float CAVE_FREQUENCY = 0.057f;
+    const int OVERHANG_SEED = 1;
+    const int CAVE_SEED = 2;
+
+    // Cave noise over the threshold is hollowed out, CAVE_DEPTH_SCALE voxels
+    // deep per unit over it. Caves keep CAVE_ROOF_DEPTH voxels below the
+    // ground unless the noise is strong enough to break through.
+    const float CAVE_THRESHOLD = 0.3f;
+    const float CAVE_DEPTH_SCALE = 16.0f;
+    const float CAVE_ROOF_DEPTH = 6.0f;
+
+    const int STEP = DensityField::LATTICE_STEP;
+    const int LATTICE_X = Chunk::CHUNK_SIZE_X / STEP + 1;
+    const int LATTICE_Z = Chunk::CHUNK_SIZE_Z / STEP + 1;
+    const int LATTICE_Y = (DensityField::ROWS - 1) / STEP + 2;
+    const int LATTICE_PLANE = LATTICE_X * LATTICE_Z;
+
+    static_assert(Chunk::CHUNK_SIZE_X % STEP == 0 && Chunk::CHUNK_SIZE_Z % STEP == 0,
+                  "Chunk borders must lie on the lattice so neighbouring chunks agree");
+
+    // Buffers of a sampleChunk call: noise at the lattice points, at
+    // [x + (z + y * LATTICE_Z) * LATTICE_X], the lattice rows interpolated
+    // along x to every voxel column, and the heightmap as floats. Each
+    // generating thread allocates one on first use and keeps it.
+    struct SampleScratch {
+        float overhangLattice[LATTICE_Y * LATTICE_PLANE];
+        float caveLattice[LATTICE_Y * LATTICE_PLANE];
+        float overhangRows[LATTICE_Y * LATTICE_Z][Chunk::CHUNK_SIZE_X];
+        float caveRows[LATTICE_Y * LATTICE_Z][Chunk::CHUNK_SIZE_X];
+        float heights[Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Z];
+        TrackedAllocation memory{MemoryTag::GenerationScratch, sizeof(SampleScratch)};
+    };
+
+    // Integer division rounding towards negative infinity
+    int floorDiv(int value, int divisor) {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    float overhangNoise(int x, int y, int z) {
+        float noise = OVERHANG_GAIN * stb_perlin_noise3_seed(x * OVERHANG_FREQUENCY, y * OVERHANG_VERTICAL_FREQUENCY,
+                                                             z * OVERHANG_FREQUENCY, 0, 0, 0, OVERHANG_SEED);
+        // Clamped so the ground never moves further than OVERHANG_HEIGHT
+        return std::min(std::max(noise, -1.0f), 1.0f);
+    }
+
+    float caveNoise(int x, int y, int z) {
+        return stb_perlin_noise3_seed(x * CAVE_FREQUENCY, y * CAVE_FREQUENCY, z * CAVE_FREQUENCY, 0, 0, 0, CAVE_SEED);
+    }
+
+    float lerp(float a, float b, float t) {
+        return a + (b - a) * t;
+    }
+
+    // out[x] = lerp(a[x], b[x], t) for a row of a chunk's width
+    void lerpRow(const float* a, const float* b, float t, float* out) {
+        int x = 0;
+#ifdef DENSITY_FIELD_SSE
+        const __m128 tValue = _mm_set1_ps(t);
+        for (; x + 4 <= Chunk::CHUNK_SIZE_X; x += 4) {
+            __m128 start = _mm_loadu_ps(a + x);
+            _mm_storeu_ps(out + x, _mm_add_ps(start, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b + x), start), tValue)));
+        }
+#endif
+        for (; x < Chunk::CHUNK_SIZE_X; x++) {
+            out[x] = lerp(a[x], b[x], t);
+        }
+    }
+
+    // The SSE path in sampleChunk computes the same, four voxels at a time
+    float density(float overhang, float cave, float y, float height) {
+        float ground = (height - y) + DensityField::OVERHANG_HEIGHT * overhang;
+        float caveWall = (CAVE_THRESHOLD - cave) * CAVE_DEPTH_SCALE + std::max(0.0f, y - (height - CAVE_ROOF_DEPTH));
+        return std::min(ground, caveWall);
+    }
+}
+
+void DensityField::sampleChunk(int chunkX, int chunkY, int chunkZ, const HeightMap& heightMap, SolidMask& solid) {
+    const int baseX = chunkX * Chunk::CHUNK_SIZE_X;
+    const int baseY = chunkY * Chunk::CHUNK_SIZE_Y;
+    const int baseZ = chunkZ * Chunk::CHUNK_SIZE_Z;
+
+    // At and above the highest ground moved up all the way there is only
+    // air. Below the lowest ground moved down all the way only caves matter.
+    const int minHeight = *std::min_element(heightMap.begin(), heightMap.end());
+    const int maxHeight = *std::max_element(heightMap.begin(), heightMap.end());
+    if (baseY >= maxHeight + OVERHANG_HEIGHT) {
+        solid.fill(0);
+        return;
+    }
+    const bool belowGround = baseY + ROWS - 1 < minHeight - OVERHANG_HEIGHT;
+
+    thread_local std::unique_ptr<SampleScratch> scratch = std::make_unique<SampleScratch>();
+    float* overhangLattice = scratch->overhangLattice;
+    float* caveLattice = scratch->caveLattice;
+    for (int latticeY = 0; latticeY < LATTICE_Y; latticeY++) {
+        for (int latticeZ = 0; latticeZ < LATTICE_Z; latticeZ++) {
+            for (int latticeX = 0; latticeX < LATTICE_X; latticeX++) {
+                int index = latticeX + (latticeZ + latticeY * LATTICE_Z) * LATTICE_X;
+                int x = baseX + latticeX * STEP;
+                int y = baseY + latticeY * STEP;
+                int z = baseZ + latticeZ * STEP;
+                overhangLattice[index] = belowGround ? 0.0f : overhangNoise(x, y, z);
+                caveLattice[index] = caveNoise(x, y, z);
+            }
+        }
+    }
+
+    // Interpolate along x to every voxel column of the lattice rows, then
+    // along y to each row of voxels, then along z, so every step after the
+    // first works on whole rows of CHUNK_SIZE_X values
+    const int ROW = Chunk::CHUNK_SIZE_X;
+    float (*overhangRows)[ROW] = scratch->overhangRows;
+    float (*caveRows)[ROW] = scratch->caveRows;
+    for (int row = 0; row < LATTICE_Y * LATTICE_Z; row++) {
+        for (int x = 0; x < ROW; x++) {
+            const int cell = row * LATTICE_X + x / STEP;
+            const float fx = static_cast<float>(x % STEP) / STEP;
+            overhangRows[row][x] = lerp(overhangLattice[cell], overhangLattice[cell + 1], fx);
+            caveRows[row][x] = lerp(caveLattice[cell], caveLattice[cell + 1], fx);
+        }
+    }
+
+    float* heights = scratch->heights;
+    std::copy(heightMap.begin(), heightMap.end(), heights);
+
+    float overhangPlane[LATTICE_Z][ROW];
+    float cavePlane[LATTICE_Z][ROW];
+    float overhang[ROW];
+    float cave[ROW];
+    for (int y = 0; y < ROWS; y++) {
+        uint8_t* layer = &solid[y * Chunk::CHUNK_SIZE_Z * ROW];
+        if (baseY + y >= maxHeight + OVERHANG_HEIGHT) {
+            std::fill(layer, layer + Chunk::CHUNK_SIZE_Z * ROW, 0);
+            continue;
+        }
+
+        const float fy = static_cast<float>(y % STEP) / STEP;
+        const int rowBelow = (y / STEP) * LATTICE_Z;
+        for (int latticeZ = 0; latticeZ < LATTICE_Z; latticeZ++) {
+            lerpRow(overhangRows[rowBelow + latticeZ], overhangRows[rowBelow + LATTICE_Z + latticeZ], fy,
+                    overhangPlane[latticeZ]);
+            lerpRow(caveRows[rowBelow + latticeZ], caveRows[rowBelow + LATTICE_Z + latticeZ], fy, cavePlane[latticeZ]);
+        }
+
+        const float voxelY = static_cast<float>(baseY + y);
+        for (int z = 0; z < Chunk::CHUNK_SIZE_Z; z++) {
+            const float fz = static_cast<float>(z % STEP) / STEP;
+            const int latticeZ = z / STEP;
+            lerpRow(overhangPlane[latticeZ], overhangPlane[latticeZ + 1], fz, overhang);
+            lerpRow(cavePlane[latticeZ], cavePlane[latticeZ + 1], fz, cave);
+
+            const float* heightRow = heights + z * ROW;
+            uint8_t* out = layer + z * ROW;
+            int x = 0;
+#ifdef DENSITY_FIELD_SSE
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 yValue = _mm_set1_ps(voxelY);
+            const __m128 overhangHeight = _mm_set1_ps(static_cast<float>(OVERHANG_HEIGHT));
+            const __m128 caveThreshold = _mm_set1_ps(CAVE_THRESHOLD);
+            const __m128 caveDepthScale = _mm_set1_ps(CAVE_DEPTH_SCALE);
+            const __m128 caveRoofDepth = _mm_set1_ps(CAVE_ROOF_DEPTH);
+            for (; x + 4 <= ROW; x += 4) {
+                __m128 height = _mm_loadu_ps(heightRow + x);
+                __m128 ground = _mm_add_ps(_mm_sub_ps(height, yValue),
+                                           _mm_mul_ps(overhangHeight, _mm_loadu_ps(overhang + x)));
+                __m128 caveWall = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(caveThreshold, _mm_loadu_ps(cave + x)), caveDepthScale),
+                                             _mm_max_ps(zero, _mm_sub_ps(yValue, _mm_sub_ps(height, caveRoofDepth))));
+                int mask = _mm_movemask_ps(_mm_cmpgt_ps(_mm_min_ps(ground, caveWall), zero));
+                out[x] = mask & 1;
+                out[x + 1] = (mask >> 1) & 1;
+                out[x + 2] = (mask >> 2) & 1;
+                out[x + 3] = (mask >> 3) & 1;
+            }
+#endif
+            for (; x < ROW; x++) {
+                out[x] = density(overhang[x], cave[x], voxelY, heightRow[x]) > 0.0f;
+            }
+        }
+    }
+}
+
+float DensityField::sampleVoxel(int voxelX, int voxelY, int voxelZ, int height) {
+    const int x0 = floorDiv(voxelX, STEP) * STEP;
+    const int y0 = floorDiv(voxelY, STEP) * STEP;
+    const int z0 = floorDiv(voxelZ, STEP) * STEP;
+    const float fx = static_cast<float>(voxelX - x0) / STEP;
+    const float fy = static_cast<float>(voxelY - y0) / STEP;
+    const float fz = static_cast<float>(voxelZ - z0) / STEP;
+
+    // The same order as sampleChunk: along x, then y, then z
+    float overhang[2][2];
+    float cave[2][2];
+    for (int dz = 0; dz < 2; dz++) {
+        for (int dy = 0; dy < 2; dy++) {
+            int y = y0 + dy * STEP;
+            int z = z0 + dz * STEP;
+            overhang[dz][dy] = lerp(overhangNoise(x0, y, z), overhangNoise(x0 + STEP, y, z), fx);
+            cave[dz][dy] = lerp(caveNoise(x0, y, z), caveNoise(x0 + STEP, y, z), fx);
+        }
+    }
+    float overhangValue = lerp(lerp(overhang[0][0], overhang[0][1], fy), lerp(overhang[1][0], overhang[1][1], fy), fz);
+    float caveValue = lerp(lerp(cave[0][0], cave[0][1], fy), lerp(cave[1][0], cave[1][1], fy), fz);
+    return density(overhangValue, caveValue, static_cast<float>(voxelY), static_cast<float>(height));
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "../Chunk.h"
+
+// Solid or air for every voxel of the terrain. The ground follows a column
+// heightmap, pushed up and down by 3D noise into overhangs and arches, with
+// caves hollowed out below it. Both noise fields are sampled on a lattice
+// every LATTICE_STEP voxels and trilinearly interpolated in between, so a
+// chunk costs a few hundred noise samples instead of one per voxel.
+//
+// Everything here is a pure function of its arguments and safe to call
+// from any thread.
+class DensityField {
+public:
+    static const int LATTICE_STEP = 4;
+
+    // Farthest the noise moves the ground from the heightmap, in voxels
+    static const int OVERHANG_HEIGHT = 8;
+
+    // Rows sampled above a chunk, so its top voxels know how deep below the
+    // surface they are; deeper than this is stone
+    static const int ROWS_ABOVE = 3;
+    static const int ROWS = Chunk::CHUNK_SIZE_Y + ROWS_ABOVE;
+
+    // Ground height of each voxel column of a chunk column, at [x + z * CHUNK_SIZE_X]
+    using HeightMap = std::array<int, Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Z>;
+
+    // 1 for solid, at [x + (z + y * CHUNK_SIZE_Z) * CHUNK_SIZE_X] with y
+    // counting from the chunk's bottom row up to ROWS_ABOVE rows above it
+    using SolidMask = std::array<uint8_t, Chunk::CHUNK_SIZE_X * Chunk::CHUNK_SIZE_Z * ROWS>;
+
+    // Solid flags of a chunk, given the heightmap of its column
+    static void sampleChunk(int chunkX, int chunkY, int chunkZ, const HeightMap& heightMap, SolidMask& solid);
+
+    // Density of a single voxel, positive for solid, for spot checks away
+    // from a chunk. Matches sampleChunk up to rounding.
+    static float sampleVoxel(int voxelX, int voxelY, int voxelZ, int height);
+};
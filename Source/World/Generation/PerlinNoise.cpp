@@ -0,0 +1,4 @@
+// Single translation unit holding the stb_perlin implementation used by
+// terrain generation
+#define STB_PERLIN_IMPLEMENTATION
+#include "stb_perlin.h"
@@ -0,0 +1,40 @@
+#ifndef PACKED_FACE_H
+#define PACKED_FACE_H
+
+#include <cstdint>
+
+// One visible block face as drawn by VoxelRenderer, packed into 32 bits.
+// The chunk origin is a per-draw constant, so only the position inside the
+// chunk is stored:
+//   bits  0-3   local x        bits 12-14  BlockFace
+//   bits  4-7   local y        bits 15-22  block id
+//   bits  8-11  local z        bits 23-26  block light (0-15)
+// The vertex shaders decode it with the same layout, passed to them as
+// #defines by VoxelRenderer.
+using PackedFace = uint32_t;
+
+namespace PackedFaceLayout {
+    constexpr uint32_t X_BITS = 4;
+    constexpr uint32_t Y_BITS = 4;
+    constexpr uint32_t Z_BITS = 4;
+    constexpr uint32_t FACE_BITS = 3;
+    constexpr uint32_t BLOCK_BITS = 8;
+    constexpr uint32_t LIGHT_BITS = 4;
+
+    constexpr uint32_t X_SHIFT = 0;
+    constexpr uint32_t Y_SHIFT = X_SHIFT + X_BITS;
+    constexpr uint32_t Z_SHIFT = Y_SHIFT + Y_BITS;
+    constexpr uint32_t FACE_SHIFT = Z_SHIFT + Z_BITS;
+    constexpr uint32_t BLOCK_SHIFT = FACE_SHIFT + FACE_BITS;
+    constexpr uint32_t LIGHT_SHIFT = BLOCK_SHIFT + BLOCK_BITS;
+
+    static_assert(LIGHT_SHIFT + LIGHT_BITS <= 32, "PackedFace must fit in 32 bits");
+}
+
+inline PackedFace packFace(uint32_t x, uint32_t y, uint32_t z, uint32_t face, uint32_t blockId, uint32_t light) {
+    using namespace PackedFaceLayout;
+    return (x << X_SHIFT) | (y << Y_SHIFT) | (z << Z_SHIFT) |
+           (face << FACE_SHIFT) | (blockId << BLOCK_SHIFT) | (light << LIGHT_SHIFT);
+}
+
+#endif // PACKED_FACE_H
@@ -0,0 +1,90 @@
+#include "ResidencyGovernor.h"
+#include <algorithm>
+#include <cmath>
+#include "../Utils/MemoryTracker.h"
+
+namespace {
+    // The meshes and GPU buffers of a change only show up over the updates
+    // after it, so the memory is left to settle before the next decision
+    const uint64_t SETTLE_UPDATES = 30;
+
+    // Shrinking aims for, and growing stays under, this share of the budget,
+    // so the view does not flip between two distances
+    const double TARGET_FILL = 0.85;
+
+    const size_t MAX_RECENT_DECISIONS = 8;
+
+    const MemoryTag BUDGETED_TAGS[] = {
+        MemoryTag::ChunkBlocks,
+        MemoryTag::ChunkMeshes,
+        MemoryTag::ChunkSnapshots,
+        MemoryTag::ChunkColumns,
+        MemoryTag::GpuBufferMirror,
+        MemoryTag::GpuMemory
+    };
+}
+
+ResidencyGovernor::ResidencyGovernor(const Config& config)
+    : config(config),
+      maxViewDistance(std::max(1, config.streaming.viewDistance)),
+      minViewDistance(std::min(std::max(1, config.streaming.minViewDistance), maxViewDistance)),
+      budgetBytes(static_cast<int64_t>(std::max(0, config.streaming.memoryBudgetMB)) * 1024 * 1024) {
+    setViewDistance(maxViewDistance);
+}
+
+bool ResidencyGovernor::update(size_t loadedColumns) {
+    updateCount++;
+    trackedBytes = measureTrackedBytes();
+    overBudget = budgetBytes > 0 && trackedBytes > budgetBytes;
+    if (budgetBytes == 0 || loadedColumns == 0 || (lastChangeUpdate > 0 && updateCount - lastChangeUpdate < SETTLE_UPDATES)) {
+        return false;
+    }
+
+    // The view distance whose (2r + 1)^2 columns fit, at what a column costs now
+    double bytesPerColumn = static_cast<double>(trackedBytes) / loadedColumns;
+    double affordableColumns = budgetBytes * TARGET_FILL / bytesPerColumn;
+    int affordable = static_cast<int>(std::floor((std::sqrt(affordableColumns) - 1.0) / 2.0));
+    affordable = std::min(std::max(affordable, minViewDistance), maxViewDistance);
+
+    Action action;
+    if (overBudget && affordable < viewDistance) {
+        action = Action::Shrink;
+        shrinkCount++;
+    } else if (!overBudget && affordable > viewDistance) {
+        action = Action::Grow;
+        growCount++;
+    } else {
+        return false;
+    }
+
+    recentDecisions.push_back({action, viewDistance, affordable, trackedBytes, updateCount});
+    if (recentDecisions.size() > MAX_RECENT_DECISIONS) {
+        recentDecisions.pop_front();
+    }
+    lastChangeUpdate = updateCount;
+    setViewDistance(affordable);
+    return true;
+}
+
+void ResidencyGovernor::setViewDistance(int distance) {
+    viewDistance = distance;
+
+    // Each ring keeps its share of the view distance
+    auto scaleRing = [&](int ring) {
+        return (ring * viewDistance + maxViewDistance / 2) / maxViewDistance;
+    };
+    halfResolutionDistance = scaleRing(config.lod.halfResolutionDistance);
+    quarterResolutionDistance = std::max(scaleRing(config.lod.quarterResolutionDistance), halfResolutionDistance);
+}
+
+const char* ResidencyGovernor::getActionName(Action action) {
+    return action == Action::Shrink ? "shrink" : "grow";
+}
+
+int64_t ResidencyGovernor::measureTrackedBytes() {
+    int64_t bytes = 0;
+    for (MemoryTag tag : BUDGETED_TAGS) {
+        bytes += MemoryTracker::getBytes(tag);
+    }
+    return bytes;
+}
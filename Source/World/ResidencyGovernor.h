@@ -0,0 +1,81 @@
+#ifndef RESIDENCY_GOVERNOR_H
+#define RESIDENCY_GOVERNOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include "../Utils/ConfigReader.h"
+
+// Keeps the memory held for resident chunks under the budget in
+// StreamingConfig by adapting the view distance. The memory is what
+// MemoryTracker counts for chunk storage, column metadata, CPU meshes,
+// snapshots and GPU buffers. Over budget, the view shrinks to the rings
+// the budget can hold, so the farthest chunks are evicted; once there is
+// room for more rings it grows back, up to the configured distance. The
+// LOD rings scale with it.
+//
+// What one chunk column costs is estimated from the tracked bytes per
+// loaded column. The counters are process-wide and include memory not
+// tied to any chunk, such as shadow maps, which keeps the estimate on the
+// safe side.
+class ResidencyGovernor {
+public:
+    enum class Action { Shrink, Grow };
+
+    // One change of the view distance, kept for the overlay
+    struct Decision {
+        Action action;
+        int fromDistance;
+        int toDistance;
+        int64_t trackedBytes;  // When the decision was made
+        uint64_t update;       // Index of the update that made it
+    };
+
+    explicit ResidencyGovernor(const Config& config);
+
+    // Called at the start of every streaming update with the number of
+    // chunk columns loaded. Returns true if the view distance changed.
+    bool update(size_t loadedColumns);
+
+    int getViewDistance() const { return viewDistance; }
+    int getMaxViewDistance() const { return maxViewDistance; }
+    int getHalfResolutionDistance() const { return halfResolutionDistance; }
+    int getQuarterResolutionDistance() const { return quarterResolutionDistance; }
+
+    // Memory as of the last update; the budget is 0 when there is none
+    bool isOverBudget() const { return overBudget; }
+    int64_t getTrackedBytes() const { return trackedBytes; }
+    int64_t getBudgetBytes() const { return budgetBytes; }
+
+    uint64_t getUpdateCount() const { return updateCount; }
+    const std::deque<Decision>& getRecentDecisions() const { return recentDecisions; }  // Oldest first
+    uint64_t getShrinkCount() const { return shrinkCount; }
+    uint64_t getGrowCount() const { return growCount; }
+
+    static const char* getActionName(Action action);
+
+    // Bytes the budget applies to, summed over their memory tags
+    static int64_t measureTrackedBytes();
+
+private:
+    const Config& config;
+    int maxViewDistance;
+    int minViewDistance;
+    int64_t budgetBytes;
+
+    int viewDistance;
+    int halfResolutionDistance;
+    int quarterResolutionDistance;
+
+    bool overBudget = false;
+    int64_t trackedBytes = 0;
+    uint64_t updateCount = 0;
+    uint64_t lastChangeUpdate = 0;
+    uint64_t shrinkCount = 0;
+    uint64_t growCount = 0;
+    std::deque<Decision> recentDecisions;
+
+    void setViewDistance(int distance);
+};
+
+#endif // RESIDENCY_GOVERNOR_H
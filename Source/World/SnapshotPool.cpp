@@ -0,0 +1,93 @@
+#include "SnapshotPool.h"
+#include <algorithm>
+#include <new>
+
+SnapshotPool::SnapshotPool() : snapshotMemory(MemoryTag::ChunkSnapshots) {
+}
+
+std::shared_ptr<SnapshotPool> SnapshotPool::create() {
+    return std::shared_ptr<SnapshotPool>(new SnapshotPool());
+}
+
+SnapshotPool::~SnapshotPool() {
+    // Every snapshot and control block holds a reference to the pool, so
+    // by now all of them are back in the spare lists
+    for (Chunk::VoxelSnapshot* snapshot : spareSnapshots) {
+        delete snapshot;
+    }
+    for (void* block : spareControlBlocks) {
+        ::operator delete(block);
+    }
+}
+
+Chunk::SnapshotPtr SnapshotPool::capture(Chunk& chunk) {
+    if (Chunk::SnapshotPtr shared = chunk.getSharedSnapshot()) {
+        return shared;
+    }
+
+    Chunk::VoxelSnapshot* snapshot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spareSnapshots.empty()) {
+            // A new high-water mark: grow by an eighth at once, like the
+            // control blocks, with room to take every snapshot back
+            size_t extra = std::max<size_t>(1, snapshotCount / 8);
+            snapshotCount += extra;
+            snapshotMemory.resize(snapshotCount * sizeof(Chunk::VoxelSnapshot));
+            spareSnapshots.reserve(snapshotCount);
+            for (size_t i = 0; i < extra; i++) {
+                spareSnapshots.push_back(new Chunk::VoxelSnapshot());
+            }
+        }
+        snapshot = spareSnapshots.back();
+        spareSnapshots.pop_back();
+    }
+    chunk.takeSnapshot(*snapshot);
+
+    std::shared_ptr<SnapshotPool> self = shared_from_this();
+    Chunk::SnapshotPtr shared(snapshot, Recycler{self}, ControlBlockAllocator<char>(self));
+    chunk.setSharedSnapshot(shared);
+    return shared;
+}
+
+void SnapshotPool::Recycler::operator()(const Chunk::VoxelSnapshot* snapshot) const {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->spareSnapshots.push_back(const_cast<Chunk::VoxelSnapshot*>(snapshot));
+}
+
+void* SnapshotPool::allocateControlBlock(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (controlBlockSize == 0) {
+            controlBlockSize = bytes;
+        }
+        if (bytes == controlBlockSize) {
+            if (spareControlBlocks.empty()) {
+                // A new high-water mark: grow by an eighth at once, so peaks
+                // slightly above it later on still find spares
+                size_t extra = controlBlockCount / 8;
+                controlBlockCount += extra + 1;
+                spareControlBlocks.reserve(controlBlockCount);
+                for (size_t i = 0; i < extra; i++) {
+                    spareControlBlocks.push_back(::operator new(bytes));
+                }
+            } else {
+                void* block = spareControlBlocks.back();
+                spareControlBlocks.pop_back();
+                return block;
+            }
+        }
+    }
+    return ::operator new(bytes);
+}
+
+void SnapshotPool::releaseControlBlock(void* block, size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (bytes == controlBlockSize) {
+            spareControlBlocks.push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
@@ -0,0 +1,72 @@
+#ifndef SNAPSHOT_POOL_H
+#define SNAPSHOT_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Chunk.h"
+#include "../Utils/MemoryTracker.h"
+
+// Hands out immutable, reference-counted snapshots of chunk voxels. A chunk
+// is copied at most once per version: while any consumer still holds the
+// snapshot of its current version, capture() shares that one. Snapshot
+// storage and the shared_ptr control blocks are recycled once the last
+// holder lets go, on whatever thread that happens, so taking snapshots does
+// not allocate once the pool has warmed up.
+//
+// Always owned through a shared_ptr (see create()): every snapshot keeps
+// the pool alive, so consumers may hold them past the ChunkManager.
+class SnapshotPool : public std::enable_shared_from_this<SnapshotPool> {
+public:
+    static std::shared_ptr<SnapshotPool> create();
+    ~SnapshotPool();
+
+    SnapshotPool(const SnapshotPool&) = delete;
+    SnapshotPool& operator=(const SnapshotPool&) = delete;
+
+    // Snapshot of the chunk's current version. Main thread only, like every
+    // other chunk access.
+    Chunk::SnapshotPtr capture(Chunk& chunk);
+
+private:
+    SnapshotPool();
+
+    // Returns released snapshots to the pool
+    struct Recycler {
+        std::shared_ptr<SnapshotPool> pool;
+        void operator()(const Chunk::VoxelSnapshot* snapshot) const;
+    };
+
+    // Allocates the control blocks of pooled snapshots from the pool
+    template <typename T>
+    struct ControlBlockAllocator {
+        using value_type = T;
+        std::shared_ptr<SnapshotPool> pool;
+
+        explicit ControlBlockAllocator(std::shared_ptr<SnapshotPool> pool) : pool(std::move(pool)) {}
+        template <typename U>
+        ControlBlockAllocator(const ControlBlockAllocator<U>& other) : pool(other.pool) {}
+
+        T* allocate(size_t count) { return static_cast<T*>(pool->allocateControlBlock(count * sizeof(T))); }
+        void deallocate(T* block, size_t count) { pool->releaseControlBlock(block, count * sizeof(T)); }
+
+        template <typename U>
+        bool operator==(const ControlBlockAllocator<U>& other) const { return pool == other.pool; }
+        template <typename U>
+        bool operator!=(const ControlBlockAllocator<U>& other) const { return pool != other.pool; }
+    };
+
+    void* allocateControlBlock(size_t bytes);
+    void releaseControlBlock(void* block, size_t bytes);
+
+    std::mutex mutex;
+    std::vector<Chunk::VoxelSnapshot*> spareSnapshots;
+    std::vector<void*> spareControlBlocks;
+    size_t controlBlockSize = 0;   // Every pooled control block has the same type
+    size_t controlBlockCount = 0;  // Live and spare
+    size_t snapshotCount = 0;      // Live and spare
+    TrackedAllocation snapshotMemory;
+};
+
+#endif // SNAPSHOT_POOL_H